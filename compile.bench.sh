@@ -0,0 +1,3 @@
+#!/bin/sh
+RELEASE_OPTIONS="-O3 -DNDEBUG"
+exec g++ -std=c++11 -Wall -pthread $RELEASE_OPTIONS replay_bench.cpp engine.cpp player.cpp samurai.cpp util.cpp record.cpp -o replay_bench.out "$@"
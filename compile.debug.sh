@@ -1,3 +1,3 @@
 #!/bin/sh
 DEBUG_OPTIONS="-g -fsanitize=undefined -DDEBUG -D_GLIBCXX_DEBUG"
-exec g++ -std=c++11 -Wall $DEBUG_OPTIONS a.cpp samurai.cpp
+exec g++ -std=c++11 -Wall -pthread $DEBUG_OPTIONS a.cpp player.cpp samurai.cpp util.cpp record.cpp "$@"
@@ -0,0 +1,3 @@
+#!/bin/sh
+RELEASE_OPTIONS="-O3 -DNDEBUG"
+exec g++ -std=c++11 -Wall -pthread $RELEASE_OPTIONS micro_bench.cpp engine.cpp player.cpp samurai.cpp util.cpp -o micro_bench.out "$@"
@@ -1,3 +1,3 @@
 #!/bin/sh
 RELEASE_OPTIONS="-O3 -DNDEBUG"
-exec g++ -std=c++11 -Wall $RELEASE_OPTIONS a.cpp samurai.cpp
+exec g++ -std=c++11 -Wall -pthread $RELEASE_OPTIONS a.cpp player.cpp samurai.cpp util.cpp record.cpp "$@"
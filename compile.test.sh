@@ -0,0 +1,2 @@
+#!/bin/sh
+exec g++ -std=c++11 -Wall -pthread -g -fsanitize=address,undefined test.cpp engine.cpp player.cpp samurai.cpp util.cpp record.cpp -o test.out "$@"
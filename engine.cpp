@@ -0,0 +1,133 @@
+/**
+ * @file engine.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#include "engine.hpp"
+using namespace std;
+
+static int relative_field(int f, int side) {
+    return is_field_occupied(f) ? F_OCCUPIED + engine_t::relative(f - F_OCCUPIED, side) : f;
+}
+
+engine_t::engine_t(game_info_t const & ginfo) : ginfo(ginfo), turn(0), injuries() {
+    this->ginfo.side = 0;
+    field = field_t(ginfo.height, ginfo.width, F_FREE);
+    repeat (i,SAMURAI_NUM) {
+        pos[i] = ginfo.home[i];
+        state[i] = S_APPEARED;
+        cure[i] = 0;
+        // 自分の居館が存在する区画はゲーム開始時点ですでに自分により占領されており
+        field[ginfo.home[i]] = F_OCCUPIED + i;
+    }
+}
+
+game_info_t engine_t::default_game_info(int size) {
+    game_info_t ginfo = {};
+    ginfo.turns = 96;
+    ginfo.width = size;
+    ginfo.height = size;
+    ginfo.cure = 18;
+    int l = size - 1, m = size / 2;
+    const point_t home[SAMURAI_NUM] = { {0,0}, {0,m}, {m,0}, {l,l}, {l,m}, {m,l} };
+    repeat (i,SAMURAI_NUM) ginfo.home[i] = home[i];
+    return ginfo;
+}
+
+game_info_t engine_t::view_game_info(int id) const {
+    int side = id / FRIEND_NUM;
+    game_info_t g = ginfo;
+    g.side = side;
+    g.weapon = id % FRIEND_NUM;
+    repeat (i,SAMURAI_NUM) {
+        int j = relative(i, side);
+        g.home[j] = ginfo.home[i];
+        g.rank[j] = ginfo.rank[i];
+        g.score[j] = ginfo.score[i];
+    }
+    return g;
+}
+
+turn_info_t engine_t::view(int side, bool is_masked) const {
+    field_t visible(ginfo.height, ginfo.width, not is_masked);
+    if (is_masked) {
+        repeat_from (i, side * FRIEND_NUM, (side + 1) * FRIEND_NUM) {
+            repeat (y,ginfo.height) repeat (x,ginfo.width) {
+                if (manhattan_distance(pos[i], (point_t){ y, x }) <= SIGHT) visible[y][x] = true;
+            }
+        }
+    }
+    turn_info_t tinfo;
+    tinfo.turn = turn;
+    tinfo.cure = 0;
+    repeat (i,SAMURAI_NUM) {
+        int j = relative(i, side);
+        if (j < FRIEND_NUM or (state[i] == S_APPEARED and visible[pos[i]])) {
+            tinfo.pos[j] = pos[i];
+            tinfo.state[j] = state[i];
+        } else {
+            tinfo.pos[j] = (point_t){ -1, -1 };
+            tinfo.state[j] = S_HIDDEN;
+        }
+    }
+    tinfo.field = field_t(ginfo.height, ginfo.width);
+    tinfo.tiles = tile_map_t(ginfo.height, ginfo.width);
+    repeat (y,ginfo.height) repeat (x,ginfo.width) {
+        tinfo.field[y][x] = visible[y][x] ? relative_field(field[y][x], side) : F_UNKNOWN;
+        if (visible[y][x]) tinfo.tiles.mark((point_t){ y, x }, TILE_KNOWN);
+    }
+    return tinfo;
+}
+
+turn_info_t engine_t::view_turn_info(int id) const {
+    turn_info_t tinfo = view(id / FRIEND_NUM, true);
+    tinfo.cure = cure[id];
+    return tinfo;
+}
+
+int engine_t::play(action_plan_t const & plan) {
+    int id = current_samurai();
+    int side = id / FRIEND_NUM;
+    game_info_t g = view_game_info(id);
+    turn_info_t truth = view(side, false);
+    truth.cure = cure[id];
+    field_t f = truth.field;
+    simulator_t sim(g, truth, f);
+    int n = 0;
+    for (int a : plan.a) {
+        if (not sim.apply(a)) break;
+        ++ n;
+        if (not is_action_attack(a)) continue;
+        for (auto it = sim.last_changes_begin(); it != sim.last_changes_end(); ++ it) {
+            point_t q = it->q;
+            repeat (i,SAMURAI_NUM) {
+                int j = relative(i, side);
+                // 他のサムライの居館が存在する区画は占領されない
+                if (i != id and q == ginfo.home[i]) f[q] = F_OCCUPIED + j;
+                // 敵のサムライは、居館にいる場合を除いて負傷し、居館に戻る
+                if (j >= FRIEND_NUM and q == pos[i] and q != ginfo.home[i]) {
+                    pos[i] = truth.pos[j] = ginfo.home[i];
+                    state[i] = truth.state[j] = S_APPEARED;
+                    cure[i] = ginfo.cure;
+                    injuries[side] += 1;
+                }
+            }
+        }
+    }
+    pos[id] = sim.pos();
+    state[id] = sim.state();
+    repeat (y,ginfo.height) repeat (x,ginfo.width) {
+        field[y][x] = relative_field(f[y][x], side);
+    }
+    ++ turn;
+    repeat (i,SAMURAI_NUM) if (cure[i]) -- cure[i];
+    return n;
+}
+
+array<int,2> engine_t::territory() const {
+    array<int,2> cnt = {};
+    repeat (y,ginfo.height) repeat (x,ginfo.width) {
+        if (is_field_occupied(field[y][x])) cnt[(field[y][x] - F_OCCUPIED) / FRIEND_NUM] += 1;
+    }
+    return cnt;
+}
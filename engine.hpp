@@ -0,0 +1,35 @@
+/**
+ * @file engine.hpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#pragma once
+#include "samurai.hpp"
+
+/**
+ * a referee in process, which keeps the whole state of a game and shows each samurai what it may see
+ * @note samurai ids are absolute here: 0-2 are the side 0 and 3-5 are the side 1, as in TURNS
+ */
+class engine_t {
+    game_info_t ginfo; // as the side 0 sees
+    int turn;
+    std::array<point_t,SAMURAI_NUM> pos;
+    std::array<int,SAMURAI_NUM> state;
+    std::array<int,SAMURAI_NUM> cure; // the turns left until the samurai recovers
+    std::array<int,2> injuries; // injuries[side] -> the number of enemies the side has injured
+    field_t field; // cells hold absolute ids
+    turn_info_t view(int side, bool is_masked) const;
+public:
+    static const int SIGHT = 5; // サムライの視界はマンハッタン距離 5 以内
+    explicit engine_t(game_info_t const & ginfo);
+    static game_info_t default_game_info(int size = 15); // the board of 96 turns used in the contest, or its scaled one
+    static int relative(int id, int side) { return (id + side * FRIEND_NUM) % SAMURAI_NUM; } // the id seen from the side, and vice versa
+    int current_turn() const { return turn; }
+    int current_samurai() const { return TURNS[turn % TURN_CYCLE]; }
+    bool is_over() const { return turn >= ginfo.turns; }
+    game_info_t view_game_info(int id) const;
+    turn_info_t view_turn_info(int id) const; // what the samurai id is told in this turn
+    int play(action_plan_t const & plan); // for the current samurai, returns the length of the valid prefix done
+    std::array<int,2> territory() const; // the number of cells each side occupies
+    int injured(int side) const { return injuries[side]; }
+};
@@ -0,0 +1,170 @@
+/**
+ * @file host.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief serves many games in one process, each by its own player, over a tagged text protocol
+ * @note usage: ./host.out [-j threads] [-t seconds per game] [-w width] [-d depth] [file]...
+ *     each message of the referee protocol is prefixed with "@id", the id of its game, on stdin or on each of the files (e.g. fifos)
+ *     the first message of an id is the game info, and the following ones are the turn infos
+ *     the replies are written to stdout with the same tags, in the order they are ready
+ *     a game is forgotten after its last turn, and then the id may be used again
+ *     the players search on 1 thread each, the games run in parallel on -j threads
+ */
+#include "player.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+struct game_t {
+    game_info_t ginfo; // constant once the game is made
+    unique_ptr<player> p;
+    deque<turn_info_t> pending;
+    bool busy; // in the ready queue or played by a worker
+};
+
+class host_t {
+    search_config_t config;
+    mutex lock, output;
+    condition_variable wake;
+    unordered_map<int, unique_ptr<game_t> > games;
+    deque<int> ready; // the ids of the games with pending turns
+    bool closed;
+    vector<thread> workers;
+    void reply(int id, action_plan_t & plan);
+    void work();
+public:
+    host_t(search_config_t const & config, int threads); // 0 means the number of cores
+    ~host_t(); // finishes the pending turns
+    void serve(int fd); // reads messages until the end of file
+};
+
+host_t::host_t(search_config_t const & config, int threads) : config(config), closed(false) {
+    if (threads <= 0) threads = max<int>(1, thread::hardware_concurrency());
+    repeat (i,threads) workers.emplace_back(&host_t::work, this);
+}
+host_t::~host_t() {
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+    }
+    wake.notify_all();
+    for (thread & it : workers) it.join();
+}
+
+void host_t::reply(int id, action_plan_t & plan) {
+    lock_guard<mutex> guard(output);
+    cout << '@' << id << ' ' << plan << endl; // the referee waits for it
+}
+
+void host_t::serve(int fd) {
+    scanner_t in(fd);
+    while (true) {
+        int id = in.gettag();
+        if (not in) break;
+        unique_lock<mutex> guard(lock);
+        auto it = games.find(id);
+        if (it == games.end()) {
+            guard.unlock();
+            unique_ptr<game_t> g(new game_t());
+            in >> g->ginfo;
+            if (not in) break;
+            g->p.reset(new player(g->ginfo, config));
+            guard.lock();
+            games[id] = move(g);
+            guard.unlock();
+            action_plan_t ok;
+            reply(id, ok);
+        } else {
+            game_info_t ginfo = it->second->ginfo;
+            guard.unlock();
+            turn_info_t tinfo = getturninfo(in, ginfo);
+            if (not in) break;
+            guard.lock();
+            it = games.find(id);
+            if (it == games.end()) continue; // after the last turn
+            game_t & g = *it->second;
+            g.pending.push_back(move(tinfo));
+            if (not g.busy) {
+                g.busy = true;
+                ready.push_back(id);
+                wake.notify_one();
+            }
+        }
+    }
+}
+
+void host_t::work() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [&]() { return closed or not ready.empty(); });
+        if (ready.empty()) break;
+        int id = ready.front();
+        ready.pop_front();
+        game_t & g = *games[id];
+        turn_info_t tinfo = move(g.pending.front());
+        g.pending.pop_front();
+        guard.unlock();
+        action_plan_t plan = g.p->play(tinfo); // the turns of a game are played one by one, so no lock
+        guard.lock();
+        if (next_turn(tinfo.turn) >= g.ginfo.turns) {
+            games.erase(id); // before the reply, so the id is free when the referee sees it
+        } else if (not g.pending.empty()) {
+            ready.push_back(id);
+        } else {
+            g.busy = false;
+        }
+        guard.unlock();
+        reply(id, plan);
+        guard.lock();
+    }
+}
+
+int main(int argc, char **argv) {
+    int threads = 0;
+    search_config_t config = DEFAULT_SEARCH_CONFIG;
+    config.threads = 1;
+    config.verbose = false;
+    vector<char const *> files;
+    repeat_from (i,1,argc) {
+        char const *opt = argv[i];
+        if (opt[0] != '-') {
+            files.push_back(opt);
+            continue;
+        }
+        if (i + 1 == argc) {
+            cerr << "missing argument: " << opt << endl;
+            return 1;
+        }
+        char const *arg = argv[++ i];
+        if      (not strcmp(opt, "-j")) threads = atoi(arg);
+        else if (not strcmp(opt, "-t")) config.time_limit = atof(arg);
+        else if (not strcmp(opt, "-w")) config.width = atoi(arg);
+        else if (not strcmp(opt, "-d")) config.depth = atoi(arg);
+        else {
+            cerr << "unknown option: " << opt << endl;
+            return 1;
+        }
+    }
+    vector<int> fds;
+    for (char const *path : files) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "failed to open: " << path << endl;
+            return 1;
+        }
+        fds.push_back(fd);
+    }
+    if (fds.empty()) fds.push_back(0);
+
+    {
+        host_t host(config, threads);
+        vector<thread> readers;
+        for (int fd : fds) readers.emplace_back(&host_t::serve, &host, fd);
+        for (thread & it : readers) it.join();
+    }
+    for (int fd : fds) if (fd) close(fd);
+    INSTRUMENT_FLUSH(cerr);
+    return 0;
+}
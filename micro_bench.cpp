@@ -0,0 +1,267 @@
+/**
+ * @file micro_bench.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief measures each primitive alone on synthetic boards, in ns and heap allocations per call
+ * @note usage: ./micro_bench.out [-s size]... [-c candidates]... [-t seconds per measurement] [--json]
+ *     the sizes are 15 to 1024 by default, and the candidates are the estimated positions per enemy
+ *     "vs area" is the growth of ns/op from the previous size divided by the growth of the area,
+ *     so about 1 is linear in the area, and much more than 1 is super-linear
+ */
+#include "player.hpp"
+#include "engine.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+static atomic<long long> allocations(0);
+void *operator new(size_t n) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    void *p = malloc(n ? n : 1);
+    if (not p) throw bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct bench_result_t {
+    string name;
+    int size, candidates; // 0 if it does not depend on them
+    double ns, allocs; // per op
+};
+static double min_time = 0.05;
+static vector<bench_result_t> results;
+static volatile long long sink; // keeps the results of the ops alive
+
+// runs f doubling the count until it takes min_time
+template <typename F>
+void bench(char const *name, int size, int candidates, F f) {
+    typedef chrono::steady_clock clock;
+    f(); // warm up, e.g. the arena and the capacities
+    for (long long n = 1; ; n *= 2) {
+        long long a = allocations;
+        clock::time_point begin = clock::now();
+        repeat (i,n) f();
+        double t = chrono::duration<double>(clock::now() - begin).count();
+        if (t >= min_time or n >= (1ll << 30)) {
+            results.push_back((bench_result_t){ name, size, candidates, t / n * 1e9, double(allocations - a) / n });
+            return;
+        }
+    }
+}
+
+/**
+ * a board of the size seen by the samurai 0, where an enemy has attacked us from hiding since our previous turn
+ */
+struct board_t {
+    game_info_t ginfo;
+    turn_info_t prev, cur;
+    vector<point_t> observed; // the cells which differ between prev and cur
+    point_t attacker; // where the enemy 0 attacked from
+};
+board_t make_board(int size, mt19937 & gen) {
+    board_t b;
+    b.ginfo = engine_t::default_game_info(size);
+    b.ginfo.side = 0;
+    b.ginfo.weapon = 0;
+    uniform_int_distribution<int> coord(engine_t::SIGHT, size - 1 - engine_t::SIGHT);
+    turn_info_t & t = b.prev;
+    t.turn = 6;
+    t.cure = 0;
+    repeat (i,SAMURAI_NUM) {
+        if (i < FRIEND_NUM) {
+            t.pos[i] = (point_t){ coord(gen), coord(gen) };
+            t.state[i] = S_APPEARED;
+        } else {
+            t.pos[i] = (point_t){ -1, -1 };
+            t.state[i] = S_HIDDEN;
+        }
+    }
+    t.field = field_t(size, size, F_UNKNOWN);
+    repeat (i,FRIEND_NUM) {
+        point_t p = t.pos[i];
+        repeat_from (y, max(0, p.y - engine_t::SIGHT), min(size, p.y + engine_t::SIGHT + 1)) {
+            repeat_from (x, max(0, p.x - engine_t::SIGHT), min(size, p.x + engine_t::SIGHT + 1)) {
+                if (manhattan_distance(p, (point_t){ y, x }) > engine_t::SIGHT) continue;
+                int r = gen() % 4;
+                t.field[y][x] = r == 0 ? F_FREE : r == 1 ? F_OCCUPIED + gen() % FRIEND_NUM : F_OCCUPIED + FRIEND_NUM + gen() % ENEMY_NUM;
+            }
+        }
+    }
+    b.cur = b.prev;
+    b.cur.turn = 6 + TURN_CYCLE / 2;
+    b.attacker = t.pos[0] + (point_t){ 2, 0 };
+    for_each_attacked(0, D_SOUTH, b.attacker, b.ginfo, [&](point_t const & q) {
+        if (b.cur.field[q] != F_UNKNOWN) b.cur.field[q] = F_OCCUPIED + FRIEND_NUM;
+    });
+    repeat (y,size) repeat (x,size) if (b.prev.field[y][x] != b.cur.field[y][x]) b.observed.push_back((point_t){ y, x });
+    return b;
+}
+
+string to_text(turn_info_t const & t) {
+    ostringstream out;
+    out << t.turn << ' ' << t.cure << '\n';
+    repeat (i,SAMURAI_NUM) out << t.pos[i].x << ' ' << t.pos[i].y << ' ' << t.state[i] << '\n';
+    repeat (y,t.field.height) {
+        repeat (x,t.field.width) out << int(t.field[y][x]) << ' ';
+        out << '\n';
+    }
+    return out.str();
+}
+
+/**
+ * drives the private phases of player
+ */
+struct player_probe_t {
+    static void set_estimation(player & p, board_t const & b, int candidates, mt19937 & gen) {
+        p.tinfo = b.cur;
+        p.pfield = b.prev.field;
+        p.observed = b.observed;
+        p.history.push(b.prev);
+        p.last_turn = b.prev.turn;
+        p.eranges.assign(1, array<int,ENEMY_NUM>{{ 1, 1, 1 }});
+        uniform_int_distribution<int> coord(0, b.ginfo.height - 1);
+        repeat (i,ENEMY_NUM) {
+            p.eposs[i].clear();
+            repeat (k,candidates) p.eposs[i].push_back((point_t){ coord(gen), coord(gen) });
+            p.eweights[i].assign(candidates, 1.0 / candidates);
+        }
+    }
+    static void update_is_dangerous(player & p) {
+        p.arena.reset();
+        p.update_is_dangerous(0);
+    }
+    static void update_estimated_positions(player & p, array<vector<point_t>,ENEMY_NUM> const & eposs, array<vector<double>,ENEMY_NUM> const & eweights, int last_turn) {
+        p.arena.reset();
+        repeat (i,ENEMY_NUM) { // since the last call has moved them
+            p.eposs[i].assign(eposs[i].begin(), eposs[i].end());
+            p.eweights[i].assign(eweights[i].begin(), eweights[i].end());
+        }
+        p.last_turn = last_turn;
+        p.update_estimated_positions();
+    }
+    static array<vector<point_t>,ENEMY_NUM> const & eposs(player const & p) { return p.eposs; }
+    static array<vector<double>,ENEMY_NUM> const & eweights(player const & p) { return p.eweights; }
+};
+
+void bench_board(int size, vector<int> const & candidates) {
+    mt19937 gen(size);
+    board_t b = make_board(size, gen);
+
+    string text = to_text(b.cur);
+    FILE *fp = tmpfile();
+    fwrite(text.data(), 1, text.size(), fp);
+    fflush(fp);
+    int fd = fileno(fp);
+    bench("getint", size, 0, [&]() {
+        lseek(fd, 0, SEEK_SET);
+        scanner_t in(fd);
+        long long acc = 0;
+        repeat (i, 2 + SAMURAI_NUM * 3 + size * size) acc += in.getint();
+        sink = acc;
+    });
+    bench("getturninfo", size, 0, [&]() {
+        lseek(fd, 0, SEEK_SET);
+        scanner_t in(fd);
+        sink = getturninfo(in, b.ginfo).field.data.size();
+    });
+    fclose(fp);
+
+    action_plan_t plan;
+    plan.a = { A_MOVE + D_SOUTH, A_ATTACK + D_EAST, A_MOVE + D_EAST };
+    bench("is_valid_plan", size, 0, [&]() {
+        sink = is_valid_plan(plan, b.ginfo, b.cur);
+    });
+    bench("simulate_plan", size, 0, [&]() {
+        sink = simulate_plan(plan, b.cur.field, b.cur.pos[0], b.ginfo)[b.cur.pos[0]];
+    });
+
+    search_config_t config = DEFAULT_SEARCH_CONFIG;
+    config.threads = 1;
+    config.verbose = false;
+    for (int c : candidates) {
+        config.belief_size = max(config.belief_size, c);
+        player p(b.ginfo, config);
+        player_probe_t::set_estimation(p, b, c, gen);
+        bench("update_is_dangerous", size, c, [&]() {
+            player_probe_t::update_is_dangerous(p);
+        });
+        array<vector<point_t>,ENEMY_NUM> eposs = player_probe_t::eposs(p);
+        array<vector<double>,ENEMY_NUM> eweights = player_probe_t::eweights(p);
+        bench("update_estimated_positions", size, c, [&]() {
+            player_probe_t::update_estimated_positions(p, eposs, eweights, b.prev.turn);
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    vector<int> sizes, candidates;
+    bool json = false;
+    repeat_from (i,1,argc) {
+        char const *opt = argv[i];
+        if (not strcmp(opt, "--json")) {
+            json = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            cerr << "missing argument: " << opt << endl;
+            return 1;
+        }
+        char const *arg = argv[++ i];
+        if      (not strcmp(opt, "-s")) sizes.push_back(atoi(arg));
+        else if (not strcmp(opt, "-c")) candidates.push_back(atoi(arg));
+        else if (not strcmp(opt, "-t")) min_time = atof(arg);
+        else {
+            cerr << "unknown option: " << opt << endl;
+            return 1;
+        }
+    }
+    if (sizes.empty()) sizes = { 15, 31, 63, 127, 255, 511, 1024 };
+    if (candidates.empty()) candidates = { 1, 16, 64 };
+    for (int size : sizes) {
+        if (size < 2 * engine_t::SIGHT + 1) {
+            cerr << "too small: " << size << endl;
+            return 1;
+        }
+    }
+
+    // the ones which do not depend on the board
+    bench("rotdir", 0, 0, [&]() {
+        static int d = 0;
+        d = (d + 1) % DIRECTION_NUM;
+        sink = rotdir(ATTACK_AREA_AXE[0], d).y;
+    });
+    bench("turns_to_next", 0, 0, [&]() {
+        static int turn = 0;
+        turn = (turn + 1) % TURN_CYCLE;
+        sink = turns_to_next(turn)[0];
+    });
+    for (int size : sizes) bench_board(size, candidates);
+
+    if (json) cout << "[" << endl;
+    repeat (k,int(results.size())) {
+        bench_result_t const & r = results[k];
+        // the same op on the previous size
+        double growth = 0;
+        repeat_reverse (j,k) {
+            bench_result_t const & q = results[j];
+            if (q.name == r.name and q.candidates == r.candidates and q.size and r.size) {
+                growth = (r.ns / q.ns) / (double(r.size) * r.size / (double(q.size) * q.size));
+                break;
+            }
+        }
+        if (json) {
+            cout << "  { \"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"candidates\": " << r.candidates
+                 << ", \"ns_per_op\": " << r.ns << ", \"allocs_per_op\": " << r.allocs
+                 << ", \"vs_area\": " << growth << " }" << (k + 1 < int(results.size()) ? "," : "") << endl;
+        } else {
+            if (k == 0) printf("%-28s %6s %5s %14s %10s %10s %8s\n", "name", "size", "cand", "ns/op", "ns/cell", "allocs/op", "vs area");
+            printf("%-28s %6d %5d %14.1f %10.3f %10.2f %8s\n", r.name.c_str(), r.size, r.candidates, r.ns,
+                   r.size ? r.ns / (double(r.size) * r.size) : 0, r.allocs, growth ? to_string(growth).substr(0, 5).c_str() : "-");
+        }
+    }
+    if (json) cout << "]" << endl;
+    return 0;
+}
@@ -0,0 +1,677 @@
+/**
+ * @file player.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @todo
+ *     - 敵の位置推測
+ *         - 以前ターンでの推測結果の利用すべき
+ *     - 移動
+ *         - 斧持っているなら積極的に動くべき
+ *             - 塗り効率が3から5.3になる
+ *         - 開幕直後に3マス移動すべき
+ *         - 2手先ぐらいまで読むべき
+ *             - 特にある敵に対し2回行動できるとき
+ *     - コード
+ *         - 敵を倒す -> 塗る -> 大きく動く の3つに分けると綺麗になりそう
+ */
+#include "player.hpp"
+using namespace std;
+
+player::player(game_info_t const & ginfo, search_config_t const & config)
+        : ginfo(ginfo), history(config.history_size), config(config), timer(config.time_limit, config.turn_time_limit), profile() {
+    pool.reset(new thread_pool_t(config.threads));
+    workers.resize(pool->size());
+    for (worker_t & wk : workers) {
+        wk.evaluations = 0;
+        wk.cache.assign(CACHE_SIZE, make_pair(0, 0));
+    }
+
+    repeat (i,SAMURAI_NUM) rhome[ginfo.home[i]] = i;
+
+    efield = field_state_t(field_t(h(), w(), F_UNKNOWN));
+    for (worker_t & wk : workers) wk.field = efield;
+
+    // enemies start at their homes
+    last_turn = -1;
+    belief = grid_t<double>(h(), w());
+    repeat (i,ENEMY_NUM) {
+        eposs[i].assign(1, ginfo.home[FRIEND_NUM + i]);
+        eweights[i].assign(1, 1);
+    }
+}
+
+void player::update_estimated_positions() {
+    stopwatch_t watch(profile.estimate);
+    INSTRUMENT_TIMER("update_estimated_positions");
+    array<bool,ENEMY_NUM> is_hidden;
+    repeat (i,ENEMY_NUM) {
+        is_hidden[i] = not is_on_field(tinfo.pos[FRIEND_NUM + i], ginfo);
+    }
+    typedef arena_vector_t<point_t> points_t;
+    array<points_t,ENEMY_NUM> inferred = {{ points_t(arena), points_t(arena), points_t(arena) }}; // positions which explain the attacks since our last turn
+    if (not history.empty()) {
+        // gather difference
+        // efield agreed with pfield where pfield is known, so only the observed cells may differ
+        array<points_t,ENEMY_NUM> attacked = {{ points_t(arena), points_t(arena), points_t(arena) }};
+        for (point_t q : observed) {
+            int cur = tinfo.field[q];
+            int prv = pfield[q];
+            if (cur == prv) continue;
+            if (prv == F_UNKNOWN) continue;
+            if (not is_field_enemy(cur)) continue;
+            attacked[cur - F_OCCUPIED - FRIEND_NUM].push_back(q);
+        }
+        repeat (i,ENEMY_NUM) {
+            sort(attacked[i].begin(), attacked[i].end()); // sort to search
+        }
+        // gather aposs
+        // an origin which explains the attack covers attacked[i][0], so look only at the origins from the inverse footprints
+        array<points_t,ENEMY_NUM> aposs = {{ points_t(arena), points_t(arena), points_t(arena) }}; // positions where enemy might attack from
+        repeat (i,ENEMY_NUM) if (is_hidden[i] and not attacked[i].empty()) {
+            for_each_attacker(i, attacked[i].front(), ginfo, [&](point_t const & p, int j) {
+                int n = 0;
+                bool is_consistent = true;
+                for_each_attacked(i, j, p, ginfo, [&](point_t const & q) {
+                    if (tinfo.field[q] == F_UNKNOWN) return;
+                    if (pfield[q] == F_UNKNOWN) return;
+                    if (pfield[q] == F_OCCUPIED + FRIEND_NUM + i) return;
+                    if (binary_search(attacked[i].begin(), attacked[i].end(), q)) {
+                        ++ n;
+                    } else {
+                        is_consistent = false;
+                    }
+                });
+                if (is_consistent and n == int(attacked[i].size())) aposs[i].push_back(p);
+            });
+            sort(aposs[i].begin(), aposs[i].end());
+            aposs[i].erase(unique(aposs[i].begin(), aposs[i].end()), aposs[i].end());
+        }
+        // construct inferred
+        repeat (i,ENEMY_NUM) if (is_hidden[i] and not attacked[i].empty()) {
+            point_t prv = history.back().pos[FRIEND_NUM + i];
+            if (not is_on_field(prv, ginfo)) {
+                // from hidden, appear -> attack -> hide
+                for (point_t apos : aposs[i]) {
+                    if (is_field_enemy(tinfo.field[apos.y][apos.x]) and
+                            is_field_enemy(pfield[apos.y][apos.x])) {
+                        inferred[i].push_back(apos);
+                    }
+                }
+            } else {
+                // from appearing, (attack & move) -> hide
+                for (point_t apos : aposs[i]) {
+                    if (apos == prv) {
+                        // attack -> move
+                        repeat (j,DIRECTION_NUM+1) {
+                            point_t q = prv + direction[j];
+                            if (not is_on_field(q, ginfo)) continue;
+                            if (not is_field_enemy(tinfo.field[q.y][q.x])) continue;
+                            inferred[i].push_back(q);
+                        }
+                    } else {
+                        // move -> attack
+                        if (manhattan_distance(prv, apos) > 1) continue;
+                        if (not is_field_enemy(tinfo.field[apos.y][apos.x])) continue;
+                        inferred[i].push_back(apos);
+                    }
+                }
+            }
+        }
+
+#ifdef DEBUG
+if (config.verbose) {
+point_t lo, hi; // the box in sight, as debug_print()
+tinfo.tiles.bounds(h(), w(), TILE_KNOWN, lo, hi);
+int bw = hi.x - lo.x;
+arena_vector_t<char> f((hi.y - lo.y) * bw, 0, arena);
+repeat_from (y,lo.y,hi.y) {
+    repeat_from (x,lo.x,hi.x) {
+        if (tinfo.field[y][x] == F_UNKNOWN) {
+            f[(y - lo.y) * bw + x - lo.x] = '#';
+        } else {
+            f[(y - lo.y) * bw + x - lo.x] = '.';
+        }
+    }
+}
+auto in_box = [&](point_t const & p) { return lo.y <= p.y and p.y < hi.y and lo.x <= p.x and p.x < hi.x; };
+repeat (i,ENEMY_NUM) {
+    for (point_t p : aposs[i]) if (in_box(p)) {
+        f[(p.y - lo.y) * bw + p.x - lo.x] = 'd' + i;
+    }
+}
+repeat (i,ENEMY_NUM) {
+    for (point_t p : inferred[i]) if (in_box(p)) {
+        f[(p.y - lo.y) * bw + p.x - lo.x] = 'D' + i;
+    }
+}
+repeat_from (y,lo.y,hi.y) {
+    repeat_from (x,lo.x,hi.x) {
+        cerr << f[(y - lo.y) * bw + x - lo.x];
+    }
+    cerr << '\n';
+}
+}
+#endif
+
+    }
+
+    // update the beliefs
+    array<int,ENEMY_NUM> actions = turns_between(last_turn, tinfo.turn);
+    repeat (i,ENEMY_NUM) {
+        if (not is_hidden[i]) {
+            eposs[i].assign(1, tinfo.pos[FRIEND_NUM + i]);
+            eweights[i].assign(1, 1);
+        } else if (not inferred[i].empty()) {
+            eposs[i].assign(inferred[i].begin(), inferred[i].end());
+            eweights[i].assign(eposs[i].size(), 1);
+            normalize_belief(i);
+        } else {
+            propagate_belief(i, actions[i]);
+        }
+    }
+    last_turn = tinfo.turn;
+    repeat (i,ENEMY_NUM) INSTRUMENT_VALUE("eposs", eposs[i].size());
+}
+
+// moves the belief of the hidden enemy i by its actions, and drops the positions which contradict the field we see
+void player::propagate_belief(int i, int actions) {
+    vector<point_t> & ps = eposs[i];
+    vector<double> & ws = eweights[i];
+    int r = 3 * actions; // an action moves at most 3
+    arena_vector_t<point_t> touched(arena);
+    repeat (k,int(ps.size())) {
+        point_t p = ps[k];
+        int n = 0;
+        repeat (pass,2) { // count the reachable cells, then spread the weight over them
+            repeat_from (y, max(0, p.y - r), min(h(), p.y + r + 1)) {
+                int dx = r - abs(y - p.y);
+                repeat_from (x, max(0, p.x - dx), min(w(), p.x + dx + 1)) {
+                    point_t q = { y, x };
+                    auto it = rhome.find(q);
+                    if (it != rhome.end() and it->second != FRIEND_NUM + i) continue; // 他のサムライの居館には入れない
+                    if (pass == 0) {
+                        ++ n;
+                    } else {
+                        if (belief[q] == 0) touched.push_back(q);
+                        belief[q] += ws[k] / n;
+                    }
+                }
+            }
+        }
+    }
+    ps.clear();
+    ws.clear();
+    for (point_t q : touched) {
+        // 隠伏は自軍の領地でしかできない
+        int f = tinfo.field[q];
+        if (f == F_UNKNOWN or is_field_enemy(f)) {
+            ps.push_back(q);
+            ws.push_back(belief[q]);
+        }
+        belief[q] = 0;
+    }
+    if (ps.empty()) {
+        // nothing explains what we see, so it may have been killed
+        ps.assign(1, ginfo.home[FRIEND_NUM + i]);
+        ws.assign(1, 1);
+    }
+    normalize_belief(i);
+}
+
+// merges the same positions, keeps the most probable ones up to the limit, and makes the weights sum to 1
+void player::normalize_belief(int i) {
+    vector<point_t> & ps = eposs[i];
+    vector<double> & ws = eweights[i];
+    arena_vector_t<int> ixs(arena);
+    repeat (k,int(ps.size())) {
+        if (belief[ps[k]] == 0) ixs.push_back(k);
+        belief[ps[k]] += ws[k];
+    }
+    sort(ixs.begin(), ixs.end(), [&](int a, int b) {
+        double wa = belief[ps[a]], wb = belief[ps[b]];
+        return wa != wb ? wa > wb : ps[a] < ps[b];
+    });
+    if (int(ixs.size()) > config.belief_size) ixs.resize(config.belief_size);
+    arena_vector_t<point_t> nps(arena);
+    arena_vector_t<double> nws(arena);
+    double total = 0;
+    for (int k : ixs) {
+        nps.push_back(ps[k]);
+        nws.push_back(belief[ps[k]]);
+        total += nws.back();
+    }
+    for (point_t q : ps) belief[q] = 0;
+    for (double & it : nws) it /= total;
+    ps.assign(nps.begin(), nps.end());
+    ws.assign(nws.begin(), nws.end());
+}
+
+void player::update_is_dangerous(int ply) {
+    stopwatch_t watch(profile.danger);
+    INSTRUMENT_TIMER("update_is_dangerous");
+    if (int(is_dangerous.size()) <= ply) is_dangerous.resize(ply + 1);
+    repeat (i,ENEMY_NUM) {
+        is_dangerous[ply][i].build(i, eposs[i], eranges[ply][i], ginfo);
+    }
+    is_dangerous_ready = ply + 1;
+}
+
+// whether an enemy may reach us before our next turn
+bool player::is_urgent() const {
+    repeat (i,ENEMY_NUM) if (eturns[i]) {
+        for (point_t p : eposs[i]) {
+            // move at most 3 in each of its turns, and then attack once
+            const int moves = ACTION_COST_LIMIT / ACTION_COST[A_MOVE];
+            if (manhattan_distance(p, pos()) <= eturns[i] * moves + ATTACK_REACH) return true;
+        }
+    }
+    return false;
+}
+
+// the number of our turns, including this one
+int player::turns_left() const {
+    int n = 0;
+    for (int turn = tinfo.turn; turn < ginfo.turns; turn = next_turn(turn)) ++ n;
+    return n;
+}
+
+void player::update() {
+    stopwatch_t watch(profile.update);
+    INSTRUMENT_TIMER("update");
+    eturns = turns_to_next(tinfo);
+    eranges.resize(config.depth);
+    int turn = tinfo.turn;
+    repeat (ply,config.depth) {
+        array<int,ENEMY_NUM> next = turns_to_next(turn);
+        repeat (i,ENEMY_NUM) eranges[ply][i] = (ply ? eranges[ply-1][i] : 0) + next[i];
+        turn = next_turn(turn);
+    }
+    observed.clear();
+    for_each_changed_cell(efield.field(), tinfo.field, F_UNKNOWN, tinfo.tiles, TILE_KNOWN, [&](point_t const & q) {
+        efield.set(q, tinfo.field[q]);
+        observed.push_back(q);
+    });
+    // since the last sync, efield has changed only here and by our plan
+    for (worker_t & wk : workers) {
+        for_each_changed_cell(wk.field.field(), efield.field(), -1, efield.dirty_tiles(), TILE_DIRTY, [&](point_t const & q) {
+            wk.field.set(q, efield[q]);
+        });
+        wk.field.clean();
+    }
+    efield.clean();
+    INSTRUMENT_VALUE("territory", efield.territory(0) - efield.territory(1));
+    INSTRUMENT_VALUE("frontier", efield.frontier_size());
+    update_estimated_positions();
+    update_is_dangerous(0); // the others are built when the search reaches them
+}
+
+action_plan_t player::play(turn_info_t const & a_tinfo) {
+    timer.start();
+    arena.reset();
+    if (a_tinfo.turn >= 6) history.push(tinfo);
+    update_turn_info(tinfo, a_tinfo);
+    // > 自分の居館が存在する区画はゲーム開始時点ですでに自分により占領されており、ゲーム中に他のサムライによって占領されることはない。
+    // arenaにおいても、自陣を再占領しないと隠伏できないので無効化
+    // // とあるが、tinfo.fieldには反映されていないので対応
+    // repeat (i,SAMURAI_NUM) {
+    //     point_t p = ginfo.home[i];
+    //     tinfo.field[p.y][p.x] = F_OCCUPIED + i;
+    // }
+    update();
+    timer.set_budget(turns_left(), is_urgent() ? config.urgent_weight : 1);
+
+#ifdef DEBUG
+    if (config.verbose) debug_print(pos(), efield.field(), ginfo, tinfo);
+#endif
+
+    action_plan_t plan = decide_plan();
+    copy_known(tinfo.field, tinfo.tiles, pfield, pfield_tiles);
+    // our paint is within a move and an attack
+    const int reach = (ACTION_COST_LIMIT - ACTION_COST[A_ATTACK]) / ACTION_COST[A_MOVE] + ATTACK_REACH;
+    pfield_tiles.mark(pos().y - reach, pos().x - reach, pos().y + reach + 1, pos().x + reach + 1, TILE_KNOWN);
+    simulator_t(ginfo, tinfo, pfield).apply(plan);
+    simulator_t(ginfo, tinfo, efield).apply(plan);
+    timer.stop();
+    profile.turns += 1;
+    return plan;
+}
+
+player_stats_t player::stats() const {
+    player_stats_t s = profile;
+    for (worker_t const & wk : workers) s.evaluations += wk.evaluations;
+    return s;
+}
+
+action_plan_t player::decide_plan() {
+    stopwatch_t watch(profile.decide);
+    INSTRUMENT_TIMER("decide_plan");
+    action_plan_t plan;
+    if (tinfo.cure) return plan;
+    if (state() == S_ELIMINATED) return plan;
+
+    // deepen iteratively while the time remains, the plan of the deepest finished search is used
+    // reserve for A_HIDE too, so that the plans never grow
+    action_plan_t greedy;
+    greedy.a.reserve(simulator_t::MAX_ACTIONS + 1);
+    plan.a.reserve(simulator_t::MAX_ACTIONS + 1);
+    double highscore = - INFINITY, first = - INFINITY;
+    repeat_from (depth,1,min(config.depth, turns_left())+1) {
+        double score, first_score;
+        if (not beam_search(depth, greedy, score, first_score)) break; // which keeps greedy if false
+        highscore = score;
+        first = first_score;
+        if (timer.is_over()) break;
+    }
+    plan = greedy;
+
+#ifdef DEBUG
+    if (config.verbose) cerr << "score: " << highscore << '\n';
+#endif
+    if (first < 200) { // the threshold is for the score of one turn, so the later turns do not count
+        // there are no enough space, goto center (heuristic)
+        auto is_unoccupied = [&](point_t const & p) { return not is_field_friend(efield[p]); };
+        int r = config.center_radius ? config.center_radius : max(ginfo.height, ginfo.width);
+        int y = pos().y, x = pos().x;
+        area.build(max(0, y-r), max(0, x-r), min(h(), y+r+1), min(w(), x+r+1), is_unoccupied); // only what the scores see
+        double score[DIRECTION_NUM] = {};
+        score[D_NORTH] = area.count(y-r, x-r, y,     x+r+1);
+        score[D_SOUTH] = area.count(y+1, x-r, y+r+1, x+r+1);
+        score[D_WEST]  = area.count(y-r, x-r, y+r+1, x);
+        score[D_EAST]  = area.count(y-r, x+1, y+r+1, x+r+1);
+        highscore = -1; // shadowing
+        int j = -1;
+        repeat (i,DIRECTION_NUM) {
+            if (highscore < score[i]) {
+                highscore = score[i];
+                j = i;
+            }
+        }
+        if (highscore == 0) {
+            // nothing in sight, so walk toward the nearest one
+            grid_t<int> dist = distance_field(ginfo, is_unoccupied, [&](point_t const & p) {
+                repeat (i,SAMURAI_NUM) if (i != ginfo.weapon and p == ginfo.home[i]) return false;
+                return state() != S_HIDDEN or is_field_friend(efield[p]);
+            });
+            int best = -1;
+            repeat (i,DIRECTION_NUM) {
+                point_t p = pos() + direction[i];
+                if (not is_on_field(p, ginfo) or dist[p] == -1) continue;
+                if (best == -1 or dist[p] < best) {
+                    best = dist[p];
+                    j = i;
+                }
+            }
+        }
+
+        plan.a.clear();
+        plan.a.push_back(A_MOVE + j);
+        plan.a.push_back(A_MOVE + j);
+        plan.a.push_back(A_MOVE + j);
+        if (state() == S_HIDDEN and not is_valid(plan)) {
+            plan.a.clear();
+            plan.a.push_back(A_APPEAR);
+            plan.a.push_back(A_MOVE + j);
+            plan.a.push_back(A_MOVE + j);
+            plan.a.push_back(A_MOVE + j);
+        }
+        plan.a.resize(valid_prefix(plan));
+
+        point_t p = pos() + total_move(plan);
+        bool dangerous = false;
+        repeat (i,ENEMY_NUM) {
+            if (is_dangerous[0][i].any(p)) dangerous = true;
+        }
+        if (dangerous) plan = greedy; // revert
+    }
+    plan.a.push_back(A_HIDE);
+    plan.a.resize(valid_prefix(plan));
+    return plan;
+}
+
+// the checks run on efield, which agrees with tinfo.field around us
+bool player::is_valid(action_plan_t const & plan) {
+    return valid_prefix(plan) == int(plan.a.size());
+}
+int player::valid_prefix(action_plan_t const & plan) {
+    simulator_t sim(ginfo, tinfo, efield);
+    int n = sim.apply(plan);
+    sim.undo_all();
+    return n;
+}
+
+// beam search over our next depth turns, walking every plan within the cost limit at each turn
+// returns false if the time is over, and then result is left as it is
+bool player::beam_search(int depth, action_plan_t & result, double & highscore, double & first) {
+    arena_vector_t<beam_node_t> beam(arena), next(arena);
+    beam.reserve(config.width);
+    next.reserve(config.width);
+    beam.push_back(beam_node_t(arena));
+    beam[0].score = 0;
+    beam[0].first = 0;
+    beam[0].pos = pos();
+    beam[0].state = state();
+    beam[0].size = 0;
+    beam[0].killing = 0;
+    beam[0].a = {};
+    beam[0].hash = 0;
+    for (worker_t & wk : workers) {
+        repeat (i,ENEMY_NUM) {
+            wk.killed[i].assign(eposs[i].size(), 0);
+            wk.killed_bits[i].assign(is_dangerous[0][i].size(), 0);
+        }
+        wk.killed_hash = 0;
+    }
+    // a task is a node of the beam itself, or one of the subtrees of the trie from it
+    arena_vector_t<int> roots(arena);
+    for (int j = 1; j < ACTION_TRIE_SIZE; j += ACTION_TRIE[j].size) roots.push_back(j);
+    int tasks_per_node = 1 + roots.size();
+    arena_vector_t<candidate_t> candidates(arena);
+    arena_vector_t<int> order(arena);
+    repeat (ply,depth) {
+        if (is_dangerous_ready <= ply) update_is_dangerous(ply);
+        double weight = pow(config.discount, ply);
+        int tasks = beam.size() * tasks_per_node;
+        if (int(task_candidates.size()) < tasks) task_candidates.resize(tasks);
+        atomic<bool> aborted(false);
+        auto task = [&](int k, int worker) {
+            vector<candidate_t> & result = task_candidates[k];
+            result.clear();
+            if (depth > 1 and timer.is_over()) { // the first search always finishes
+                aborted = true;
+                return;
+            }
+            worker_t & wk = workers[worker];
+            beam_node_t const & node = beam[k / tasks_per_node];
+            candidate_t t;
+            t.parent = k / tasks_per_node;
+            t.size = 0;
+            paint(wk.field, node);
+            if (ply) kill(wk, node.painted.data(), node.painted.data() + node.killing, +1); // what this turn has killed stays dead
+            simulator_t sim(ginfo, tinfo, wk.field, node.pos, node.state);
+            // the table outlives a turn, so the turn is a part of the key
+            wk.context = node.hash ^ zobrist_key(Z_TURN, tinfo.turn) ^ zobrist_key(Z_PLY, ply) ^ zobrist_key(Z_FROM, yx_key(node.pos));
+            if (k % tasks_per_node == 0) {
+                t.score = node.score + weight * evaluate_cached(wk, sim, node.pos, ply);
+                result.push_back(t);
+            } else {
+                int j = roots[k % tasks_per_node - 1];
+                int a = ACTION_TRIE[j].a;
+                if (sim.apply(a)) {
+                    t.a[t.size ++] = a;
+                    if (is_action_attack(a)) {
+                        double gain = evaluate_attack(wk, sim, +1, ply);
+                        search(wk, sim, j, ply, node.pos, node.score + weight * gain, weight, t, result);
+                        evaluate_attack(wk, sim, -1, ply);
+                    } else {
+                        search(wk, sim, j, ply, node.pos, node.score, weight, t, result);
+                    }
+                    sim.undo();
+                }
+            }
+            if (ply) kill(wk, node.painted.data(), node.painted.data() + node.killing, -1);
+            unpaint(wk.field, node);
+        };
+        pool->run(tasks, ref(task)); // std::function holds a reference without allocation
+        if (aborted) return false;
+        INSTRUMENT_TIMER("beam_merge");
+        // merge in the order of tasks, so the result does not depend on the threads
+        candidates.clear();
+        repeat (k,tasks) candidates.insert(candidates.end(), task_candidates[k].begin(), task_candidates[k].end());
+        INSTRUMENT_VALUE("evaluated_plans", candidates.size());
+        // sort the indices, since stable_sort allocates its buffer from the heap
+        order.resize(candidates.size());
+        repeat (k,int(order.size())) order[k] = k;
+        sort(order.begin(), order.end(), [&](int a, int b) {
+            return candidates[a].score != candidates[b].score ? candidates[a].score > candidates[b].score : a < b; // the earlier plan wins a tie, as before
+        });
+        next.clear();
+        for (int k : order) {
+            if (int(next.size()) >= config.width) break;
+            candidate_t const & t = candidates[k];
+            beam_node_t const & parent = beam[t.parent];
+            beam_node_t node(arena);
+            node.score = t.score;
+            node.first = ply ? parent.first : t.score;
+            node.size = ply ? parent.size : 0;
+            node.a = parent.a;
+            node.painted = parent.painted;
+            field_state_t & f = workers[0].field; // efield, while not searching
+            paint(f, parent);
+            simulator_t sim(ginfo, tinfo, f, parent.pos, parent.state);
+            repeat (k,t.size) {
+                sim.apply(t.a[k]);
+                if (not ply) node.a[node.size ++] = t.a[k];
+                node.painted.insert(node.painted.end(), sim.last_changes_begin(), sim.last_changes_end());
+            }
+            node.killing = ply ? parent.killing : int(node.painted.size());
+            node.pos = sim.pos();
+            node.state = sim.state();
+            node.hash = parent.hash ^ sim.hash();
+            sim.undo_all();
+            unpaint(f, parent);
+            // drop the states which are already reached by better plans
+            bool found = false;
+            for (beam_node_t const & it : next) {
+                if (it.pos == node.pos and it.state == node.state and it.hash == node.hash) {
+                    found = true;
+                    break;
+                }
+            }
+            if (not found) next.push_back(move(node));
+        }
+        beam.swap(next);
+    }
+    result.a.assign(beam.front().a.begin(), beam.front().a.begin() + beam.front().size);
+    highscore = beam.front().score;
+    first = beam.front().first;
+    return true;
+}
+
+void player::paint(field_state_t & f, beam_node_t const & node) const {
+    for (auto const & it : node.painted) f.set(it.q, F_OCCUPIED + weapon());
+}
+void player::unpaint(field_state_t & f, beam_node_t const & node) const {
+    repeat_reverse (i,int(node.painted.size())) f.set(node.painted[i].q, node.painted[i].prv);
+}
+
+// the actions of t are applied to sim, and ACTION_TRIE[i] is the node of t
+void player::search(worker_t & wk, simulator_t & sim, int i, int ply, point_t const & from, double score, double weight, candidate_t & t, vector<candidate_t> & candidates) const {
+    t.score = score + weight * evaluate_cached(wk, sim, from, ply);
+    candidates.push_back(t);
+    for (int j = i + 1; j < i + ACTION_TRIE[i].size; j += ACTION_TRIE[j].size) {
+        int a = ACTION_TRIE[j].a;
+        if (not sim.apply(a)) continue; // the whole subtree is invalid
+        t.a[t.size ++] = a;
+        if (is_action_attack(a)) {
+            double gain = evaluate_attack(wk, sim, +1, ply);
+            search(wk, sim, j, ply, from, score + weight * gain, weight, t, candidates);
+            evaluate_attack(wk, sim, -1, ply);
+        } else {
+            search(wk, sim, j, ply, from, score, weight, t, candidates);
+        }
+        -- t.size;
+        sim.undo();
+    }
+}
+
+// scores the cells painted by the last action of sim, and counts (delta = 1) or uncounts (delta = -1) the killed enemies
+// enemies are hit only in this turn, we do not know where they will be later
+double player::evaluate_attack(worker_t & wk, simulator_t const & sim, int delta, int ply) const {
+    double score = 0;
+    if (not ply) score += 100000 * kill(wk, sim.last_changes_begin(), sim.last_changes_end(), delta);
+    for (auto it = sim.last_changes_begin(); it != sim.last_changes_end(); ++ it) {
+        point_t q = it->q;
+        // 居館の占領の可否と居館における隠伏の可否は独立のように見える
+        // if (rhome.count(q)) continue; // 自分の居館が存在する区画はゲーム開始時点ですでに自分により占領されており、ゲーム中に他のサムライによって占領されることはない。
+        // それでも居館への攻撃はあまりおいしくなさそう
+        repeat (i,ENEMY_NUM) if (ginfo.home[FRIEND_NUM + i] == q) score -= 30;
+
+        int fq = it->prv;
+        if (is_field_enemy(fq)) {
+            score += 110;
+        } else if (fq == F_FREE or fq == F_UNKNOWN) {
+            score += 100;
+        } if (is_field_friend(fq) and fq == F_OCCUPIED + weapon()) {
+            score += 1;
+        }
+    }
+    return score;
+}
+
+// counts (delta > 0) or uncounts the attacks on the estimated positions in the cells, and returns the sum of their weights
+// the danger of every ply excludes the positions with attacks, through killed_bits
+double player::kill(worker_t & wk, simulator_t::change_t const *begin, simulator_t::change_t const *end, int delta) const {
+    double weight = 0;
+    for (auto it = begin; it != end; ++ it) {
+        point_t q = it->q;
+        repeat (j,ENEMY_NUM) {
+            repeat (k,int(eposs[j].size())) {
+                if (q == eposs[j][k]) {
+                    if (q == ginfo.home[FRIEND_NUM + j]) continue; // 居館上は無敵っぽい
+                    if (delta > 0 ? wk.killed[j][k] ++ == 0 : -- wk.killed[j][k] == 0) {
+                        wk.killed_bits[j][k / 64] ^= 1ull << (k % 64);
+                        wk.killed_hash ^= zobrist_key(Z_KILLED, uint64_t(j) << 32 | k);
+                    }
+                    weight += eweights[j][k];
+                }
+            }
+        }
+    }
+    return weight;
+}
+
+// evaluate() through the transposition table, since different orders of actions often reach the same state
+double player::evaluate_cached(worker_t & wk, simulator_t const & sim, point_t const & from, int ply) const {
+    point_t p = sim.pos();
+    uint64_t key = wk.context ^ sim.hash() ^ wk.killed_hash
+        ^ zobrist_key(Z_POS, yx_key(p))
+        ^ zobrist_key(Z_STATE, sim.state() << 1 | (sim.cost() < ACTION_COST_LIMIT));
+    pair<uint64_t,double> & entry = wk.cache[key & (CACHE_SIZE - 1)];
+    if (entry.first == key) return entry.second;
+    ++ wk.evaluations;
+    entry = make_pair(key, evaluate(wk, sim, from, ply));
+    return entry.second;
+}
+
+// scores the position reached by sim from the position from, other than its attacks
+double player::evaluate(worker_t const & wk, simulator_t const & sim, point_t const & from, int ply) const {
+    double score = 0;
+    point_t p = sim.pos();
+    if (sim.cost() < ACTION_COST_LIMIT and is_field_friend(sim.field()[p])) {
+        score += 10;
+    }
+    repeat (i,FRIEND_NUM) if (i != weapon()) {
+        int dist_diff = manhattan_distance(p, tinfo.pos[i]) - manhattan_distance(from, tinfo.pos[i]);
+        score += dist_diff * 5;
+    }
+    // O(1), since the worker's field keeps the frontier as the search paints it
+    score += config.frontier_weight * (wk.field.frontier_size() - efield.frontier_size());
+    repeat (i,ENEMY_NUM) {
+        double threat = 0;
+        is_dangerous[ply][i].for_each_excluding(p, wk.killed_bits[i].data(), [&](int k) {
+            threat += eweights[i][k];
+        });
+        score -= 150000 * threat;
+    }
+    return score;
+}
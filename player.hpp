@@ -0,0 +1,120 @@
+/**
+ * @file player.hpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#pragma once
+#include "samurai.hpp"
+#include "util.hpp"
+#include <memory>
+
+struct search_config_t {
+    int width; // the number of states kept after each of our turns
+    int depth; // the number of our turns to read at most, including this one
+    double discount; // the weight of a turn relative to the previous one
+    double time_limit; // seconds for the whole game
+    double turn_time_limit; // seconds at most for a turn
+    double urgent_weight; // how much more time a turn gets when an enemy may attack us soon
+    int threads; // the number of threads to search with, 0 means the number of cores
+    int belief_size; // the number of estimated positions kept at most for an enemy
+    bool verbose; // print the field and the estimations to cerr, only in the DEBUG build
+    int history_size; // the number of past turns remembered
+    int center_radius; // how far the fallback of decide_plan() looks for unoccupied cells, 0 means the whole board
+    double frontier_weight; // the score of a cell by which a plan grows the frontier of our territory
+};
+const search_config_t DEFAULT_SEARCH_CONFIG = { 8, 8, 0.5, 10.0, 0.5, 2.0, 0, 64, true, 16, 8, 20 };
+
+// where the time of play() goes, summed over the turns
+// update includes estimate and the danger of the ply 0, and decide includes the danger of the other plies
+struct player_stats_t {
+    int turns;
+    double update, estimate, danger, decide; // seconds
+    long long evaluations; // calls of evaluate()
+};
+
+class player {
+    game_info_t ginfo;
+    history_t history; // the turn infos of our previous turns
+    turn_info_t tinfo;
+    field_t pfield;
+    tile_map_t pfield_tiles; // TILE_KNOWN of pfield
+    field_state_t efield; // the last seen value of each cell, and our paint since then
+    std::vector<point_t> observed; // the cells of efield which the turn info of this turn changed
+    std::array<std::vector<point_t>,ENEMY_NUM> eposs; // estimated positions of enemies
+    std::array<std::vector<double>,ENEMY_NUM> eweights; // eweights[enemy id][eposs ix] -> the probability, sums to 1 for each enemy
+    int last_turn; // the turn of the previous update, or -1
+    grid_t<double> belief; // all 0 between uses, to merge the weights of the same cells
+    std::vector<std::array<danger_map_t,ENEMY_NUM> > is_dangerous; // is_dangerous[ply][enemy id] -> the eposs ixs which threaten each cell until our ply-th next turn
+    int is_dangerous_ready; // the number of plies built in this turn
+    std::array<int,ENEMY_NUM> eturns;
+    std::vector<std::array<int,ENEMY_NUM> > eranges; // eranges[ply][enemy id] -> the number of enemy turns until our ply-th next turn
+    search_config_t config;
+    time_manager_t timer;
+    struct worker_t { // the scratch of a search thread
+        field_state_t field; // efield, while not searching
+        std::array<std::vector<int>,ENEMY_NUM> killed; // killed[enemy id][eposs ix] -> the number of attacks on the current search path
+        std::array<std::vector<uint64_t>,ENEMY_NUM> killed_bits; // killed_bits[enemy id] -> { eposs ixs whose killed is not 0 }
+        long long evaluations;
+        uint64_t killed_hash; // the xor of zobrist_key(Z_KILLED, ...) of the killed eposs
+        uint64_t context; // the hash of what the evaluation of the current task depends on, other than sim and killed
+        std::vector<std::pair<uint64_t,double> > cache; // the transposition table of evaluate(), indexed by the lower bits of the key
+    };
+    static const int CACHE_SIZE = 1 << 14;
+    std::unique_ptr<thread_pool_t> pool;
+    std::vector<worker_t> workers;
+    std::map<point_t,int> rhome; // reversed home
+    player_stats_t profile; // without evaluations, which the workers count
+    arena_t arena; // the scratch of a turn, reset by play()
+    summed_area_t area; // of the cells not ours, for the fallback of decide_plan()
+
+    int weapon() const { return ginfo.weapon; }
+    int h() const { return ginfo.height; }
+    int w() const { return ginfo.width; }
+    int state() const { return tinfo.state[ginfo.weapon]; }
+    point_t pos() const { return tinfo.pos[ginfo.weapon]; }
+
+private:
+    void update();
+    void update_estimated_positions();
+    void propagate_belief(int i, int actions);
+    void normalize_belief(int i);
+    void update_is_dangerous(int ply);
+    bool is_urgent() const;
+    int turns_left() const;
+    action_plan_t decide_plan();
+    bool beam_search(int depth, action_plan_t & result, double & highscore, double & first); // first is the score of this turn in the best line
+    bool is_valid(action_plan_t const & plan);
+    int valid_prefix(action_plan_t const & plan);
+    struct beam_node_t {
+        double score;
+        double first; // the part of score from this turn
+        point_t pos;
+        int state;
+        int size;
+        std::array<int,simulator_t::MAX_ACTIONS> a; // the plan of this turn, which the node comes from
+        arena_vector_t<simulator_t::change_t> painted; // the cells painted since this turn, in order
+        int killing; // the first cells of painted, which this turn painted, so whose attacks kill
+        uint64_t hash; // the xor of zobrist_key(Z_CELL, ...) of the cells which have become ours since this turn
+        explicit beam_node_t(arena_t & arena) : painted(arena) {}
+    };
+    struct candidate_t {
+        double score;
+        int parent; // the index in the beam
+        int size;
+        std::array<int,simulator_t::MAX_ACTIONS> a;
+    };
+    std::vector<std::vector<candidate_t> > task_candidates;
+    void paint(field_state_t & f, beam_node_t const & node) const;
+    void unpaint(field_state_t & f, beam_node_t const & node) const;
+    void search(worker_t & wk, simulator_t & sim, int i, int ply, point_t const & from, double score, double weight, candidate_t & t, std::vector<candidate_t> & candidates) const;
+    double evaluate_attack(worker_t & wk, simulator_t const & sim, int delta, int ply) const;
+    double kill(worker_t & wk, simulator_t::change_t const *begin, simulator_t::change_t const *end, int delta) const;
+    double evaluate(worker_t const & wk, simulator_t const & sim, point_t const & from, int ply) const;
+    double evaluate_cached(worker_t & wk, simulator_t const & sim, point_t const & from, int ply) const;
+
+public:
+    explicit player(game_info_t const & ginfo, search_config_t const & config = DEFAULT_SEARCH_CONFIG);
+    friend struct player_probe_t; // micro_bench.cpp times the private phases, and test.cpp checks them
+    action_plan_t play(turn_info_t const & tinfo);
+    player_stats_t stats() const;
+};
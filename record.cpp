@@ -0,0 +1,207 @@
+/**
+ * @file record.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#include "record.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+static const int RECORD_ALIGN = 8;
+static size_t turn_size(size_t field_size) { // with the padding
+    return (sizeof(record_turn_t) + field_size + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+}
+
+record_writer_t::record_writer_t(char const *path, game_info_t const & ginfo) : offset(0) {
+    fp = fopen(path, "wb");
+    if (not fp) return;
+    record_header_t h = {};
+    memcpy(h.magic, RECORD_MAGIC, sizeof(h.magic));
+    h.version = RECORD_VERSION;
+    h.turns  = ginfo.turns;
+    h.side   = ginfo.side;
+    h.weapon = ginfo.weapon;
+    h.width  = ginfo.width;
+    h.height = ginfo.height;
+    h.cure   = ginfo.cure;
+    repeat (i,SAMURAI_NUM) {
+        h.home[i][0] = ginfo.home[i].y;
+        h.home[i][1] = ginfo.home[i].x;
+        h.rank[i]  = ginfo.rank[i];
+        h.score[i] = ginfo.score[i];
+    }
+    write(&h, sizeof(h));
+}
+record_writer_t::~record_writer_t() {
+    if (not fp) return;
+    record_footer_t ft = {};
+    ft.index = offset;
+    ft.size = index.size();
+    memcpy(ft.magic, RECORD_MAGIC, sizeof(ft.magic));
+    write(index.data(), index.size() * sizeof(uint64_t));
+    write(&ft, sizeof(ft));
+    fclose(fp);
+}
+void record_writer_t::write(void const *data, size_t size) {
+    fwrite(data, 1, size, fp);
+    offset += size;
+}
+
+void record_writer_t::push(turn_info_t const & tinfo, action_plan_t const & plan) {
+    if (not fp) return;
+    static_assert (F_UNKNOWN < 16, "a value of a cell takes 4 bits");
+    record_turn_t t = {};
+    t.turn = tinfo.turn;
+    t.cure = tinfo.cure;
+    repeat (i,SAMURAI_NUM) {
+        t.pos[i][0] = tinfo.pos[i].y;
+        t.pos[i][1] = tinfo.pos[i].x;
+        t.state[i] = tinfo.state[i];
+    }
+    t.plan_size = min<int>(plan.a.size(), RECORD_PLAN_MAX);
+    repeat (i,t.plan_size) t.plan[i] = plan.a[i];
+    buf.clear();
+    field_t const & f = tinfo.field;
+    int value = -1, run = 0;
+    repeat (y,f.height) repeat (x,f.width) {
+        if (f[y][x] == value and run < 16) {
+            ++ run;
+        } else {
+            if (run) buf.push_back(value | (run - 1) << 4);
+            value = f[y][x];
+            run = 1;
+        }
+    }
+    if (run) buf.push_back(value | (run - 1) << 4);
+    t.field_size = buf.size();
+    buf.resize(turn_size(buf.size()) - sizeof(t));
+    index.push_back(offset);
+    write(&t, sizeof(t));
+    write(buf.data(), buf.size());
+    fflush(fp); // so that the turns so far are readable even if we are killed
+}
+
+record_reader_t::~record_reader_t() {
+    if (data) munmap(const_cast<char *>(data), length);
+}
+
+bool record_reader_t::open(char const *path) {
+    if (data) munmap(const_cast<char *>(data), length);
+    data = nullptr;
+    offsets.clear();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 or size_t(st.st_size) < sizeof(record_header_t)) {
+        close(fd);
+        return false;
+    }
+    length = st.st_size;
+    void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays
+    if (p == MAP_FAILED) return false;
+    data = static_cast<char const *>(p);
+    if (memcmp(header().magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) or header().version != RECORD_VERSION) return false;
+    if (header().height <= 0 or header().width <= 0 or int64_t(header().height) * header().width > RECORD_CELLS_MAX) return false;
+    // the values in the file are not trusted, since a record may be truncated or broken
+    auto is_turn = [&](uint64_t offset, uint64_t end) { // whether a whole turn is at offset, before end
+        if (offset < sizeof(record_header_t) or offset % RECORD_ALIGN or offset > end or end - offset < sizeof(record_turn_t)) return false;
+        return turn_size(reinterpret_cast<record_turn_t const *>(data + offset)->field_size) <= end - offset;
+    };
+    record_footer_t ft = {}; // copied, since the end of a truncated file may be misaligned
+    uint64_t end = 0; // of the index
+    if (length >= sizeof(record_header_t) + sizeof(record_footer_t)) {
+        memcpy(&ft, data + length - sizeof(record_footer_t), sizeof(ft));
+        end = length - sizeof(record_footer_t);
+    }
+    if (end and not memcmp(ft.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC))
+            and ft.index <= end and ft.size >= 0 and uint64_t(ft.size) <= (end - ft.index) / sizeof(uint64_t)
+            and ft.index + ft.size * sizeof(uint64_t) == end) {
+        offsets.resize(ft.size);
+        memcpy(offsets.data(), data + ft.index, ft.size * sizeof(uint64_t));
+        for (uint64_t offset : offsets) {
+            if (not is_turn(offset, ft.index)) {
+                offsets.clear(); // walk instead
+                break;
+            }
+        }
+    }
+    if (offsets.empty()) {
+        // without the index, walk the turns
+        uint64_t offset = sizeof(record_header_t);
+        while (is_turn(offset, length)) {
+            offsets.push_back(offset);
+            offset += turn_size(reinterpret_cast<record_turn_t const *>(data + offset)->field_size);
+        }
+    }
+    // a truncated turn is dropped above, but a whole turn with a broken field means a broken record
+    repeat (i,size()) if (not is_field(i)) return false;
+    return true;
+}
+bool record_reader_t::is_field(int i) const {
+    if (turn(i).field_size > RECORD_CELLS_MAX) return false; // a byte has a cell at least
+    uint8_t const *it = field(i);
+    int64_t cells = 0;
+    repeat (k,int(turn(i).field_size)) {
+        if ((it[k] & 15) > F_UNKNOWN) return false;
+        cells += (it[k] >> 4) + 1;
+    }
+    return cells == int64_t(header().height) * header().width;
+}
+
+game_info_t record_reader_t::game_info() const {
+    record_header_t const & h = header();
+    game_info_t ginfo = {};
+    ginfo.turns  = h.turns;
+    ginfo.side   = h.side;
+    ginfo.weapon = h.weapon;
+    ginfo.width  = h.width;
+    ginfo.height = h.height;
+    ginfo.cure   = h.cure;
+    repeat (i,SAMURAI_NUM) {
+        ginfo.home[i] = (point_t){ h.home[i][0], h.home[i][1] };
+        ginfo.rank[i]  = h.rank[i];
+        ginfo.score[i] = h.score[i];
+    }
+    return ginfo;
+}
+
+turn_info_t record_reader_t::turn_info(int i) const {
+    record_turn_t const & t = turn(i);
+    turn_info_t tinfo;
+    tinfo.turn = t.turn;
+    tinfo.cure = t.cure;
+    repeat (j,SAMURAI_NUM) {
+        tinfo.pos[j] = (point_t){ t.pos[j][0], t.pos[j][1] };
+        tinfo.state[j] = t.state[j];
+    }
+    tinfo.field = field_t(header().height, header().width);
+    tinfo.tiles = tile_map_t(header().height, header().width);
+    uint8_t const *it = field(i);
+    int y = 0, x = 0;
+    repeat (k,int(t.field_size)) {
+        int value = it[k] & 15, run = (it[k] >> 4) + 1;
+        repeat (l,run) {
+            assert (y < tinfo.field.height and value <= F_UNKNOWN); // by is_field()
+            tinfo.field[y][x] = value;
+            if (value != F_UNKNOWN) tinfo.tiles.mark((point_t){ y, x }, TILE_KNOWN);
+            if (++ x == tinfo.field.width) {
+                x = 0;
+                ++ y;
+            }
+        }
+    }
+    assert (y == tinfo.field.height and x == 0);
+    return tinfo;
+}
+
+action_plan_t record_reader_t::plan(int i) const {
+    record_turn_t const & t = turn(i);
+    action_plan_t plan;
+    plan.a.assign(t.plan, t.plan + t.plan_size);
+    return plan;
+}
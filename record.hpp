@@ -0,0 +1,84 @@
+/**
+ * @file record.hpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#pragma once
+#include "samurai.hpp"
+
+/**
+ * the binary record of a game as a player sees it, for the tools which read many games
+ * @note the layout, in the byte order of the machine:
+ *     record_header_t,
+ *     record_turn_t and its field for each turn, each padded to a multiple of 8 bytes,
+ *     the offsets of the turns as uint64_t, and record_footer_t
+ * @note a byte of a field is value | (run - 1) << 4, over the cells in row-major order
+ */
+const char RECORD_MAGIC[4] = { 'S', 'M', 'R', 'C' };
+const int RECORD_VERSION = 1;
+const int RECORD_PLAN_MAX = 15;
+const int RECORD_CELLS_MAX = 1 << 20; // of a field, so that a broken header does not allocate a huge one
+struct record_header_t {
+    char magic[4];
+    int32_t version;
+    int32_t turns, side, weapon, width, height, cure;
+    int32_t home[SAMURAI_NUM][2]; // y, x
+    int32_t rank[SAMURAI_NUM];
+    int32_t score[SAMURAI_NUM];
+};
+struct record_turn_t {
+    int32_t turn, cure;
+    int32_t pos[SAMURAI_NUM][2]; // y, x
+    int8_t state[SAMURAI_NUM];
+    uint8_t plan_size;
+    uint8_t plan[RECORD_PLAN_MAX]; // what we output
+    uint32_t field_size; // in bytes, which follow
+};
+struct record_footer_t {
+    uint64_t index; // the offset of the offsets
+    int32_t size; // the number of turns
+    char magic[4];
+};
+
+/**
+ * appends the turns of a game to a file, and writes the index when destroyed
+ */
+class record_writer_t {
+    FILE *fp;
+    uint64_t offset;
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> buf;
+    void write(void const *data, size_t size);
+public:
+    record_writer_t(char const *path, game_info_t const & ginfo);
+    ~record_writer_t();
+    record_writer_t(record_writer_t const &) = delete;
+    record_writer_t & operator = (record_writer_t const &) = delete;
+    explicit operator bool () const { return fp != nullptr; }
+    void push(turn_info_t const & tinfo, action_plan_t const & plan);
+};
+
+/**
+ * maps a record into memory and reads any turn in place
+ * @note a record without the index, e.g. of a killed process, is walked from the head instead
+ * @note open() rejects a record with a broken field, so turn_info() decodes any turn safely
+ */
+class record_reader_t {
+    char const *data;
+    size_t length;
+    std::vector<uint64_t> offsets;
+    bool is_field(int i) const; // whether the runs of the turn fill the field exactly, with the values of cells
+public:
+    record_reader_t() : data(nullptr), length(0) {}
+    ~record_reader_t();
+    record_reader_t(record_reader_t const &) = delete;
+    record_reader_t & operator = (record_reader_t const &) = delete;
+    bool open(char const *path); // false if the file is not a record
+    record_header_t const & header() const { return *reinterpret_cast<record_header_t const *>(data); }
+    game_info_t game_info() const;
+    int size() const { return offsets.size(); }
+    record_turn_t const & turn(int i) const { return *reinterpret_cast<record_turn_t const *>(data + offsets[i]); }
+    uint8_t const * field(int i) const { return reinterpret_cast<uint8_t const *>(data + offsets[i] + sizeof(record_turn_t)); } // run-length bytes
+    turn_info_t turn_info(int i) const; // decodes the field
+    action_plan_t plan(int i) const;
+};
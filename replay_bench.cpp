@@ -0,0 +1,182 @@
+/**
+ * @file replay_bench.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief measures the latency of player::play() per turn, on recorded inputs and on synthetic boards
+ * @note usage: ./replay_bench.out [-d depth] [-w width] [-j threads] [-t seconds per game] [-s size]... [--json] [file]...
+ *     a file is what the referee sends to a player, in the text protocol, or a binary record (see record.hpp)
+ *     -s plays a game of the engine on the size x size board, and times all 6 players
+ *     the time is unlimited by default, so that every turn does the same work in every run
+ */
+#include "player.hpp"
+#include "engine.hpp"
+#include "record.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+struct scenario_result_t {
+    string name;
+    vector<double> latencies; // seconds per turn
+    player_stats_t stats; // summed over the players
+};
+
+void add_stats(player_stats_t & acc, player_stats_t const & s) {
+    acc.turns += s.turns;
+    acc.update += s.update;
+    acc.estimate += s.estimate;
+    acc.danger += s.danger;
+    acc.decide += s.decide;
+    acc.evaluations += s.evaluations;
+}
+
+action_plan_t timed_play(player & p, turn_info_t const & tinfo, vector<double> & latencies) {
+    typedef chrono::steady_clock clock;
+    clock::time_point begin = clock::now();
+    action_plan_t plan = p.play(tinfo);
+    latencies.push_back(chrono::duration<double>(clock::now() - begin).count());
+    return plan;
+}
+
+bool replay_file(char const *path, search_config_t const & config, scenario_result_t & result) {
+    record_reader_t record;
+    if (record.open(path)) {
+        player p(record.game_info(), config);
+        repeat (i,record.size()) timed_play(p, record.turn_info(i), result.latencies);
+        result.name = path;
+        result.stats = p.stats();
+        return true;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    scanner_t in(fd);
+    game_info_t ginfo;
+    in >> ginfo;
+    player p(ginfo, config);
+    while (true) {
+        turn_info_t tinfo = getturninfo(in, ginfo);
+        if (not in) break;
+        timed_play(p, tinfo, result.latencies);
+    }
+    close(fd);
+    result.name = path;
+    result.stats = p.stats();
+    return true;
+}
+
+void play_synthetic(int size, search_config_t const & config, scenario_result_t & result) {
+    engine_t engine(engine_t::default_game_info(size));
+    vector<unique_ptr<player> > players;
+    repeat (i,SAMURAI_NUM) players.emplace_back(new player(engine.view_game_info(i), config));
+    while (not engine.is_over()) {
+        int i = engine.current_samurai();
+        engine.play(timed_play(*players[i], engine.view_turn_info(i), result.latencies));
+    }
+    result.name = "synthetic " + to_string(size) + "x" + to_string(size);
+    result.stats = {};
+    for (auto & p : players) add_stats(result.stats, p->stats());
+}
+
+// a JSON string literal, since a name may be a path with any characters
+string json_string(string const & s) {
+    string t = "\"";
+    for (char c : s) {
+        if (c == '"' or c == '\\') {
+            t += '\\';
+            t += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            t += buf;
+        } else {
+            t += c;
+        }
+    }
+    return t + '"';
+}
+
+double percentile(vector<double> const & xs, double p) { // xs is sorted
+    return xs.empty() ? 0 : xs[min<int>(xs.size() - 1, p * xs.size())];
+}
+
+int main(int argc, char **argv) {
+    search_config_t config = DEFAULT_SEARCH_CONFIG;
+    config.time_limit = config.turn_time_limit = 1e9;
+    config.depth = 3;
+    config.threads = 1;
+    config.verbose = false;
+    vector<int> sizes;
+    vector<char const *> files;
+    bool json = false;
+    repeat_from (i,1,argc) {
+        char const *opt = argv[i];
+        if (not strcmp(opt, "--json")) {
+            json = true;
+            continue;
+        }
+        if (opt[0] != '-') {
+            files.push_back(opt);
+            continue;
+        }
+        if (i + 1 == argc) {
+            cerr << "missing argument: " << opt << endl;
+            return 1;
+        }
+        char const *arg = argv[++ i];
+        if      (not strcmp(opt, "-d")) config.depth = atoi(arg);
+        else if (not strcmp(opt, "-w")) config.width = atoi(arg);
+        else if (not strcmp(opt, "-j")) config.threads = atoi(arg);
+        else if (not strcmp(opt, "-t")) config.time_limit = config.turn_time_limit = atof(arg);
+        else if (not strcmp(opt, "-s")) sizes.push_back(atoi(arg));
+        else {
+            cerr << "unknown option: " << opt << endl;
+            return 1;
+        }
+    }
+    if (files.empty() and sizes.empty()) sizes = { 15, 31, 63 };
+
+    vector<scenario_result_t> results;
+    for (char const *path : files) {
+        scenario_result_t result;
+        if (not replay_file(path, config, result)) {
+            cerr << "failed to open: " << path << endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+    for (int size : sizes) {
+        results.emplace_back();
+        play_synthetic(size, config, results.back());
+    }
+
+    if (json) cout << "[" << endl;
+    repeat (k,int(results.size())) {
+        scenario_result_t & r = results[k];
+        vector<double> & xs = r.latencies;
+        sort(xs.begin(), xs.end());
+        player_stats_t const & s = r.stats;
+        if (json) {
+            cout << "  { \"name\": " << json_string(r.name) << ", \"turns\": " << xs.size()
+                 << ", \"p50_ms\": " << percentile(xs, 0.5) * 1000
+                 << ", \"p99_ms\": " << percentile(xs, 0.99) * 1000
+                 << ", \"max_ms\": " << (xs.empty() ? 0 : xs.back()) * 1000
+                 << ", \"update_ms\": " << s.update * 1000
+                 << ", \"estimate_ms\": " << s.estimate * 1000
+                 << ", \"danger_ms\": " << s.danger * 1000
+                 << ", \"decide_ms\": " << s.decide * 1000
+                 << ", \"evaluations\": " << s.evaluations << " }" << (k + 1 < int(results.size()) ? "," : "") << endl;
+        } else {
+            cout << r.name << ": " << xs.size() << " turns" << endl;
+            cout << "    latency: p50 " << percentile(xs, 0.5) * 1000 << " ms, p99 " << percentile(xs, 0.99) * 1000
+                 << " ms, max " << (xs.empty() ? 0 : xs.back()) * 1000 << " ms" << endl;
+            cout << "    total: update " << s.update * 1000 << " ms, estimate " << s.estimate * 1000
+                 << " ms, danger " << s.danger * 1000 << " ms, decide " << s.decide * 1000 << " ms" << endl;
+            cout << "    evaluate: " << s.evaluations << " calls" << endl;
+        }
+    }
+    if (json) cout << "]" << endl;
+    INSTRUMENT_FLUSH(cerr);
+    return 0;
+}
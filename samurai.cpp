@@ -4,23 +4,75 @@
  * @date Tue. 05, 2016
  */
 #include "samurai.hpp"
+#include <cctype>
+#include <cerrno>
+#include <unistd.h>
 using namespace std;
 
-int getint(istream & in) {
-    string s;
+scanner_t::scanner_t(int fd) : fd(fd), l(0), r(0), eof(false), failed(false) {}
+bool scanner_t::fill() {
+    if (eof) return false;
     while (true) {
-        in >> s;
-        if (s == "#") {
-            getline(in, s);
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 and errno == EINTR) continue;
+        if (n <= 0) {
+            eof = true;
+            return false;
+        }
+        l = 0;
+        r = n;
+        return true;
+    }
+}
+bool scanner_t::skip() {
+    while (true) {
+        int c = peek();
+        if (c == EOF) {
+            return false;
+        } else if (c == '#') {
+            // a comment lasts until the end of line
+            while (c != EOF and c != '\n') {
+                ++ l;
+                c = peek();
+            }
+        } else if (isspace(c)) {
+            ++ l;
         } else {
-            return atoi(s.c_str());
+            return true;
         }
     }
 }
+int scanner_t::getint() {
+    if (not skip()) {
+        failed = true;
+        return 0;
+    }
+    bool neg = false;
+    if (peek() == '-' or peek() == '+') {
+        neg = peek() == '-';
+        ++ l;
+    }
+    int n = 0;
+    for (int c = peek(); isdigit(c); c = peek()) {
+        n = n * 10 + (c - '0');
+        ++ l;
+    }
+    // skip the rest of a malformed token, as atoi did
+    for (int c = peek(); c != EOF and not isspace(c); c = peek()) ++ l;
+    return neg ? - n : n;
+}
+int scanner_t::gettag() {
+    if (not skip() or peek() != '@') {
+        failed = true;
+        return -1;
+    }
+    ++ l;
+    return getint();
+}
 
-istream & operator >> (istream & in, point_t & p) {
-    p.x = getint(in);
-    p.y = getint(in);
+scanner_t & operator >> (scanner_t & in, point_t & p) {
+    p.x = in.getint();
+    p.y = in.getint();
     return in;
 }
 bool operator == (point_t const & a, point_t const & b) {
@@ -56,7 +108,7 @@ point_t rotdeg(point_t const & p, int degree) {
         case  90: return { - p.x,   p.y };
         case 180: return { - p.y, - p.x };
         case 270: return {   p.x, - p.y };
-        default: assert (false);
+        default: assert (false); return p;
     }
 }
 point_t rotdir(point_t const & p, int direction) {
@@ -68,19 +120,19 @@ int manhattan_distance(point_t const & a, point_t const & b) {
     return abs(c.y) + abs(c.x);
 }
 
-istream & operator >> (istream & in, game_info_t & ginfo) {
-    ginfo.turns  = getint(in);
-    ginfo.side   = getint(in);
-    ginfo.weapon = getint(in);
-    ginfo.width  = getint(in);
-    ginfo.height = getint(in);
-    ginfo.cure   = getint(in);
+scanner_t & operator >> (scanner_t & in, game_info_t & ginfo) {
+    ginfo.turns  = in.getint();
+    ginfo.side   = in.getint();
+    ginfo.weapon = in.getint();
+    ginfo.width  = in.getint();
+    ginfo.height = in.getint();
+    ginfo.cure   = in.getint();
     repeat (i,SAMURAI_NUM) {
         in >> ginfo.home[i];
     }
     repeat (i,SAMURAI_NUM) {
-        ginfo.rank[i]  = getint(in);
-        ginfo.score[i] = getint(in);
+        ginfo.rank[i]  = in.getint();
+        ginfo.score[i] = in.getint();
     }
     return in;
 }
@@ -98,22 +150,212 @@ bool is_on_field(point_t const & p, game_info_t const & ginfo) {
     return 0 <= p.y and p.y < ginfo.height and 0 <= p.x and p.x < ginfo.width;
 }
 
-turn_info_t getturninfo(istream & in, game_info_t & ginfo) {
+void tile_map_t::mark(int y0, int x0, int y1, int x1, int flag) {
+    if (empty()) return;
+    y0 = max(y0, 0); y1 = min(y1, rows * TILE);
+    x0 = max(x0, 0); x1 = min(x1, cols * TILE);
+    if (y0 >= y1 or x0 >= x1) return;
+    repeat_from (ty, y0 / TILE, (y1 - 1) / TILE + 1) {
+        repeat_from (tx, x0 / TILE, (x1 - 1) / TILE + 1) flags[ty * cols + tx] |= flag;
+    }
+}
+void tile_map_t::merge(tile_map_t const & other) {
+    if (empty()) return;
+    if (other.empty()) {
+        *this = tile_map_t();
+        return;
+    }
+    assert (rows == other.rows and cols == other.cols);
+    repeat (i,int(flags.size())) flags[i] |= other.flags[i];
+}
+void tile_map_t::bounds(int height, int width, int flag, point_t & lo, point_t & hi) const {
+    lo = (point_t){ height, width };
+    hi = (point_t){ 0, 0 };
+    for_each_segment(height, width, flag, [&](int y, int x0, int x1) {
+        lo.y = min(lo.y, y);
+        hi.y = max(hi.y, y + 1);
+        lo.x = min(lo.x, x0);
+        hi.x = max(hi.x, min(x1, width));
+    });
+    if (lo.y >= hi.y) lo = hi;
+}
+
+void copy_tiles(field_t const & from, field_t & to, tile_map_t const & tiles, int flag) {
+    if (from.height != to.height or from.width != to.width) {
+        to = from;
+        return;
+    }
+    tiles.for_each_segment(from.height, from.width, flag, [&](int y, int x0, int x1) {
+        copy(from[y] + x0, from[y] + x1, to[y] + x0);
+    });
+}
+void copy_known(field_t const & from, tile_map_t const & from_tiles, field_t & to, tile_map_t & to_tiles) {
+    if (from.height != to.height or from.width != to.width or from_tiles.empty() or to_tiles.empty()) {
+        to = from;
+    } else {
+        // the tiles known in neither are F_UNKNOWN in both
+        copy_tiles(from, to, to_tiles, TILE_KNOWN);
+        copy_tiles(from, to, from_tiles, TILE_KNOWN);
+    }
+    to_tiles = from_tiles;
+}
+
+field_state_t::field_state_t(field_t const & a_f) : f(a_f), counts(), friends(f.height, f.width), frontier(0), dirty(f.height, f.width) {
+    repeat (y,f.height) repeat (x,f.width) {
+        counts[f[y][x]] += 1;
+        if (not is_field_friend(f[y][x])) continue;
+        repeat (i,DIRECTION_NUM) {
+            point_t q = (point_t){ y, x } + direction[i];
+            if (0 <= q.y and q.y < f.height and 0 <= q.x and q.x < f.width) friends[q] += 1;
+        }
+    }
+    repeat (y,f.height) repeat (x,f.width) frontier += is_frontier((point_t){ y, x });
+}
+bool field_state_t::set(point_t const & p, int value) {
+    int prv = f[p];
+    if (prv == value) return false;
+    dirty.mark(p, TILE_DIRTY);
+    frontier -= is_frontier(p);
+    counts[prv] -= 1;
+    counts[value] += 1;
+    f[p] = value;
+    frontier += is_frontier(p);
+    if (is_field_friend(prv) != is_field_friend(value)) {
+        int delta = is_field_friend(value) ? 1 : -1;
+        repeat (i,DIRECTION_NUM) {
+            point_t q = p + direction[i];
+            if (not (0 <= q.y and q.y < f.height and 0 <= q.x and q.x < f.width)) continue;
+            frontier -= is_frontier(q);
+            friends[q] += delta;
+            frontier += is_frontier(q);
+        }
+    }
+    return true;
+}
+int field_state_t::territory(int side) const {
+    int n = 0;
+    repeat (i,FRIEND_NUM) n += counts[F_OCCUPIED + side * FRIEND_NUM + i];
+    return n;
+}
+
+turn_info_t getturninfo(scanner_t & in, game_info_t const & ginfo) {
     turn_info_t tinfo;
-    tinfo.turn = getint(in);
-    tinfo.cure = getint(in);
+    tinfo.turn = in.getint();
+    tinfo.cure = in.getint();
     repeat (i,SAMURAI_NUM) {
-        cin >> tinfo.pos[i];
-        tinfo.state[i] = getint(in);
+        in >> tinfo.pos[i];
+        tinfo.state[i] = in.getint();
     }
-    tinfo.field.resize(ginfo.height, vector<int>(ginfo.width));
+    tinfo.field = field_t(ginfo.height, ginfo.width);
+    tinfo.tiles = tile_map_t(ginfo.height, ginfo.width);
     repeat (y, ginfo.height) {
         repeat (x, ginfo.width) {
-            tinfo.field[y][x] = getint(in);
+            tinfo.field[y][x] = in.getint();
+            if (tinfo.field[y][x] != F_UNKNOWN) tinfo.tiles.mark((point_t){ y, x }, TILE_KNOWN);
         }
     }
     return tinfo;
 }
+void update_turn_info(turn_info_t & to, turn_info_t const & from) {
+    to.turn = from.turn;
+    to.cure = from.cure;
+    repeat (i,SAMURAI_NUM) {
+        to.pos[i] = from.pos[i];
+        to.state[i] = from.state[i];
+    }
+    copy_known(from.field, from.tiles, to.field, to.tiles);
+}
+
+static array<array<footprint_t,DIRECTION_NUM>,3> make_footprints() {
+    array<array<footprint_t,DIRECTION_NUM>,3> fps = {};
+    repeat (weapon,3) repeat (d,DIRECTION_NUM) {
+        footprint_t & fp = fps[weapon][d];
+        fp.size = ATTACK_AREA_NUM[weapon];
+        repeat (i,fp.size) {
+            point_t o = fp.offset[i] = rotdir(ATTACK_AREA[weapon][i], d);
+            repeat (lo,ATTACK_REACH+1) repeat (hi,ATTACK_REACH+1) {
+                // lo cells before the edge, and hi cells after
+                if (- lo <= o.y and o.y <= hi) fp.row_mask[lo][hi] |= 1 << i;
+                if (- lo <= o.x and o.x <= hi) fp.col_mask[lo][hi] |= 1 << i;
+            }
+        }
+    }
+    return fps;
+}
+static const array<array<footprint_t,DIRECTION_NUM>,3> FOOTPRINTS = make_footprints();
+footprint_t const & footprint(int weapon, int direction) {
+    return FOOTPRINTS[weapon][direction];
+}
+static array<vector<point_t>,3> make_attack_stencils() {
+    array<vector<point_t>,3> stencils;
+    repeat (weapon,3) {
+        vector<point_t> & s = stencils[weapon];
+        repeat (d,DIRECTION_NUM) {
+            footprint_t const & fp = FOOTPRINTS[weapon][d];
+            s.insert(s.end(), fp.offset, fp.offset + fp.size);
+        }
+        sort(s.begin(), s.end());
+        s.erase(unique(s.begin(), s.end()), s.end());
+    }
+    return stencils;
+}
+static const array<vector<point_t>,3> ATTACK_STENCILS = make_attack_stencils();
+vector<point_t> const & attack_stencil(int weapon) {
+    return ATTACK_STENCILS[weapon];
+}
+static array<vector<attacker_t>,3> make_inverse_footprints() {
+    array<vector<attacker_t>,3> inverses;
+    repeat (weapon,3) {
+        repeat (d,DIRECTION_NUM) {
+            footprint_t const & fp = FOOTPRINTS[weapon][d];
+            repeat (i,fp.size) inverses[weapon].push_back((attacker_t){ d, fp.offset[i] });
+        }
+    }
+    return inverses;
+}
+static const array<vector<attacker_t>,3> INVERSE_FOOTPRINTS = make_inverse_footprints();
+vector<attacker_t> const & inverse_footprint(int weapon) {
+    return INVERSE_FOOTPRINTS[weapon];
+}
+void occupy(field_t & f, int weapon, int direction, point_t const & p, game_info_t const & ginfo) {
+    for_each_attacked(weapon, direction, p, ginfo, [&](point_t const & q) {
+        f[q] = F_OCCUPIED + weapon;
+    });
+}
+
+void danger_map_t::build(int weapon, vector<point_t> const & origins, int range, game_info_t const & ginfo) {
+    int a_words = (origins.size() + 63) / 64;
+    if (height == ginfo.height and width == ginfo.width and words == a_words) {
+        // clear what the last build wrote, not the whole board
+        written.for_each_segment(height, width, TILE_DIRTY, [&](int y, int x0, int x1) {
+            fill(bits.data() + (y * width + x0) * words, bits.data() + (y * width + min(x1, width)) * words, 0);
+        });
+        written.clear(TILE_DIRTY);
+    } else {
+        height = ginfo.height;
+        width = ginfo.width;
+        words = a_words;
+        bits.assign(height * width * words, 0);
+        written = tile_map_t(height, width);
+    }
+    if (not range) return;
+    repeat (k,int(origins.size())) {
+        // the origins of the attack form a rectangle, so each offset of the stencil shifts it to another one
+        point_t p = origins[k];
+        int y0 = max(0, p.y - range), y1 = min(ginfo.height-1, p.y + range);
+        int x0 = max(0, p.x - range), x1 = min(ginfo.width -1, p.x + range);
+        uint64_t bit = 1ull << (k % 64);
+        written.mark(y0 - ATTACK_REACH, x0 - ATTACK_REACH, y1 + ATTACK_REACH + 1, x1 + ATTACK_REACH + 1, TILE_DIRTY);
+        for (point_t const & o : attack_stencil(weapon)) {
+            int ty1 = min(ginfo.height-1, y1 + o.y);
+            int tx0 = max(0, x0 + o.x), tx1 = min(ginfo.width-1, x1 + o.x);
+            repeat_from (ty, max(0, y0 + o.y), ty1+1) {
+                uint64_t * row = bits.data() + ty * width * words + k / 64;
+                repeat_from (tx,tx0,tx1+1) row[tx * words] |= bit;
+            }
+        }
+    }
+}
 
 bool is_action_attack(int a) {
     return A_ATTACK <= a and a < A_ATTACK + DIRECTION_NUM;
@@ -143,89 +385,168 @@ point_t total_move(action_plan_t const & plan) {
     return p;
 }
 
-bool is_valid_plan(action_plan_t const & plan) {
-    // 10 種の行動から任意のものを
-    for (int a : plan.a) if (a < 1 or 10 < a) return false;
-    // そのコストの計が 7 以下である範囲で任意数選んで指示することができる
-    if (total_cost(plan) > 7) return false;
-    return true;
-}
 bool is_valid_plan(action_plan_t const & plan, game_info_t const & ginfo, turn_info_t const & tinfo) {
-    if (plan.a.empty()) return true;
-    if (tinfo.cure) return false;
-    if (not is_valid_plan(plan)) return false;
-    point_t p = tinfo.pos[ginfo.weapon];
-    int s = tinfo.state[ginfo.weapon];
-    vector<vector<int> > f = tinfo.field;
-    if (s == S_ELIMINATED) return false;
+    field_t f = tinfo.field;
+    simulator_t sim(ginfo, tinfo, f);
+    return sim.apply(plan) == int(plan.a.size());
+}
+
+field_t simulate_plan(action_plan_t const & plan, field_t f, point_t p, game_info_t const & ginfo) {
     for (int a : plan.a) {
         if (is_action_attack(a)) {
-            // 隠伏している間は占領行動をできない
-            if (s == S_HIDDEN) return false;
-            repeat (i, ATTACK_AREA_NUM[ginfo.weapon]) {
-                point_t q = p + rotdir(ATTACK_AREA[ginfo.weapon][i], a - A_ATTACK);
-                if (not is_on_field(q, ginfo)) continue;
-                // 居館の占領の可否と居館における隠伏の可否は独立のように見える
-                // bool is_home = false;
-                // repeat (j,SAMURAI_NUM) if (q == ginfo.home[j]) {
-                //     is_home = true; break;
-                // }
-                // if (is_home) continue;
-                f[q.y][q.x] = F_OCCUPIED + ginfo.weapon;
-            }
+            occupy(f, ginfo.weapon, a - A_ATTACK, p, ginfo);
         } else if (is_action_move(a)) {
             p += direction[a - A_MOVE];
-            if (not is_on_field(p, ginfo)) return false;
-            if (s == S_APPEARED) {
-                repeat (i,SAMURAI_NUM) if (i != ginfo.weapon) {
-                    // 姿を隠していない状態で他のサムライがいる区画に移動することはできない
-                    if (tinfo.state[i] == S_APPEARED and p == tinfo.pos[i]) return false;
-                }
-            } else {
-                // 姿を隠しながら味方の領地以外の区画に移動することはできない
-                if (not is_field_friend(f[p.y][p.x])) return false;
-            }
-            repeat (i,SAMURAI_NUM) if (i != ginfo.weapon) {
-                // 他のサムライの居館の区画には移動できない
-                if (p == ginfo.home[i]) return false;
-            }
-        } else if (a == A_HIDE) {
-            // 隠伏は味方の領地にいるときしかできない
-            if (not is_field_friend(f[p.y][p.x])) return false;
-            // XXX: 隠伏中に隠伏は可能？
-            if (s == S_HIDDEN) return false;
-            s = S_HIDDEN;
-        } else if (a == A_APPEAR) {
+        }
+    }
+    return f;
+}
+
+simulator_t::simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_t & f)
+        : ginfo(ginfo), tinfo(tinfo), f(f), fs(nullptr),
+          p(tinfo.pos[ginfo.weapon]), s(tinfo.state[ginfo.weapon]), c(0), h(0),
+          frame_size(0), change_size(0) {}
+simulator_t::simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_t & f, point_t const & p, int s)
+        : ginfo(ginfo), tinfo(tinfo), f(f), fs(nullptr), p(p), s(s), c(0), h(0),
+          frame_size(0), change_size(0) {}
+simulator_t::simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_state_t & fs)
+        : ginfo(ginfo), tinfo(tinfo), f(fs.f), fs(&fs),
+          p(tinfo.pos[ginfo.weapon]), s(tinfo.state[ginfo.weapon]), c(0), h(0),
+          frame_size(0), change_size(0) {}
+simulator_t::simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_state_t & fs, point_t const & p, int s)
+        : ginfo(ginfo), tinfo(tinfo), f(fs.f), fs(&fs), p(p), s(s), c(0), h(0),
+          frame_size(0), change_size(0) {}
+bool simulator_t::apply(int a) {
+    if (tinfo.cure) return false;
+    if (s == S_ELIMINATED) return false;
+    // 10 種の行動から任意のものを
+    if (a < 1 or 10 < a) return false;
+    // そのコストの計が 7 以下である範囲で任意数選んで指示することができる
+    if (c + ACTION_COST[a] > ACTION_COST_LIMIT) return false;
+    frame_t & fr = frames[frame_size];
+    fr.a = a;
+    fr.p = p;
+    fr.s = s;
+    fr.cost = c;
+    fr.hash = h;
+    fr.changes = change_size;
+    if (is_action_attack(a)) {
+        // 隠伏している間は占領行動をできない
+        if (s == S_HIDDEN) return false;
+        // 居館の占領の可否と居館における隠伏の可否は独立のように見える
+        for_each_attacked(ginfo.weapon, a - A_ATTACK, p, ginfo, [&](point_t const & q) {
+            changes[change_size ++] = (change_t){ q, f[q] };
+            if (f[q] != F_OCCUPIED + ginfo.weapon) h ^= zobrist_key(Z_CELL, yx_key(q));
+            write(q, F_OCCUPIED + ginfo.weapon);
+        });
+    } else if (is_action_move(a)) {
+        point_t np = p + direction[a - A_MOVE];
+        if (not is_on_field(np, ginfo)) return false;
+        if (s == S_APPEARED) {
             repeat (i,SAMURAI_NUM) if (i != ginfo.weapon) {
-                // 同じ区画に姿を隠していない他のサムライがいる場合には、顕現できない
-                if (tinfo.state[i] == S_APPEARED and p == tinfo.pos[i]) return false;
+                // 姿を隠していない状態で他のサムライがいる区画に移動することはできない
+                if (tinfo.state[i] == S_APPEARED and np == tinfo.pos[i]) return false;
             }
-            // XXX: 顕現中に顕現は可能？
-            if (s == S_APPEARED) return false;
-            s = S_APPEARED;
+        } else {
+            // 姿を隠しながら味方の領地以外の区画に移動することはできない
+            if (not is_field_friend(f[np])) return false;
+        }
+        repeat (i,SAMURAI_NUM) if (i != ginfo.weapon) {
+            // 他のサムライの居館の区画には移動できない
+            if (np == ginfo.home[i]) return false;
         }
+        p = np;
+    } else if (a == A_HIDE) {
+        // 隠伏は味方の領地にいるときしかできない
+        if (not is_field_friend(f[p])) return false;
+        // XXX: 隠伏中に隠伏は可能？
+        if (s == S_HIDDEN) return false;
+        s = S_HIDDEN;
+    } else if (a == A_APPEAR) {
+        repeat (i,SAMURAI_NUM) if (i != ginfo.weapon) {
+            // 同じ区画に姿を隠していない他のサムライがいる場合には、顕現できない
+            if (tinfo.state[i] == S_APPEARED and p == tinfo.pos[i]) return false;
+        }
+        // XXX: 顕現中に顕現は可能？
+        if (s == S_APPEARED) return false;
+        s = S_APPEARED;
     }
+    c += ACTION_COST[a];
+    ++ frame_size;
     return true;
 }
-
-vector<vector<int> > simulate_plan(action_plan_t const & plan, vector<vector<int> > f, point_t p, game_info_t const & ginfo) {
+int simulator_t::apply(action_plan_t const & plan) {
+    int n = 0;
     for (int a : plan.a) {
-        if (is_action_attack(a)) {
-            repeat (i, ATTACK_AREA_NUM[ginfo.weapon]) {
-                point_t q = p + rotdir(ATTACK_AREA[ginfo.weapon][i], a - A_ATTACK);
-                if (not is_on_field(q, ginfo)) continue;
-                f[q.y][q.x] = F_OCCUPIED + ginfo.weapon;
-            }
-        } else if (is_action_move(a)) {
-            p += direction[a - A_MOVE];
-        }
+        if (not apply(a)) break;
+        ++ n;
     }
-    return f;
+    return n;
+}
+void simulator_t::undo() {
+    assert (frame_size);
+    frame_t const & fr = frames[-- frame_size];
+    while (change_size > fr.changes) {
+        change_t const & ch = changes[-- change_size];
+        write(ch.q, ch.prv);
+    }
+    p = fr.p;
+    s = fr.s;
+    c = fr.cost;
+    h = fr.hash;
+}
+void simulator_t::undo_all() {
+    while (frame_size) undo();
 }
 
-void debug_print(point_t const & p, vector<vector<int> > const & f, game_info_t const & ginfo, turn_info_t const & tinfo) {
-    repeat (y,ginfo.height) {
-        repeat (x,ginfo.width) {
+template <int... Is> struct int_sequence {};
+template <typename S, typename T> struct concat_int_sequence;
+template <int... Is, int... Js> struct concat_int_sequence<int_sequence<Is...>, int_sequence<Js...> > {
+    typedef int_sequence<Is..., (int(sizeof...(Is)) + Js)...> type;
+};
+template <int N> struct make_int_sequence {
+    typedef typename concat_int_sequence<typename make_int_sequence<N/2>::type, typename make_int_sequence<N-N/2>::type>::type type;
+};
+template <> struct make_int_sequence<0> { typedef int_sequence<> type; };
+template <> struct make_int_sequence<1> { typedef int_sequence<0> type; };
+
+// memoize the sizes of subtrees, since action_trie_size() takes exponential time
+template <int... Is>
+static constexpr std::array<int,sizeof...(Is)> make_action_trie_sizes(int_sequence<Is...>) {
+    return {{ action_trie_size(Is)... }};
+}
+static constexpr std::array<int,ACTION_COST_LIMIT+1> ACTION_TRIE_SIZES = make_action_trie_sizes(make_int_sequence<ACTION_COST_LIMIT+1>::type());
+// i is the offset from the child a of a node with the budget
+static constexpr int action_trie_action(int i, int budget, int a = A_ATTACK) {
+    return ACTION_COST[a] > budget ? action_trie_action(i, budget, a + 1)
+         : i == 0 ? a
+         : i < ACTION_TRIE_SIZES[budget - ACTION_COST[a]] ? action_trie_action(i - 1, budget - ACTION_COST[a])
+         : action_trie_action(i - ACTION_TRIE_SIZES[budget - ACTION_COST[a]], budget, a + 1);
+}
+static constexpr int action_trie_budget(int i, int budget, int a = A_ATTACK) { // the budget left after the node
+    return ACTION_COST[a] > budget ? action_trie_budget(i, budget, a + 1)
+         : i == 0 ? budget - ACTION_COST[a]
+         : i < ACTION_TRIE_SIZES[budget - ACTION_COST[a]] ? action_trie_budget(i - 1, budget - ACTION_COST[a])
+         : action_trie_budget(i - ACTION_TRIE_SIZES[budget - ACTION_COST[a]], budget, a + 1);
+}
+template <int... Is>
+static constexpr std::array<action_trie_node_t,sizeof...(Is)> make_action_trie(int_sequence<Is...>) {
+    return {{ { Is == 0 ? 0 : action_trie_action(Is - 1, ACTION_COST_LIMIT),
+                ACTION_TRIE_SIZES[Is == 0 ? ACTION_COST_LIMIT : action_trie_budget(Is - 1, ACTION_COST_LIMIT)] }... }};
+}
+constexpr std::array<action_trie_node_t,ACTION_TRIE_SIZE> ACTION_TRIE = make_action_trie(make_int_sequence<ACTION_TRIE_SIZE>::type());
+static_assert (ACTION_TRIE[1].a == A_ATTACK and ACTION_TRIE[1].size == action_trie_size(ACTION_COST_LIMIT - ACTION_COST[A_ATTACK]), "");
+static_assert (ACTION_TRIE[ACTION_TRIE_SIZE-1].a == A_APPEAR and ACTION_TRIE[ACTION_TRIE_SIZE-1].size == 1, "");
+
+void debug_print(point_t const & p, field_t const & f, game_info_t const & ginfo, turn_info_t const & tinfo) {
+    // only the box of the tiles in sight, since the rest of a large board is a wall of unknown cells
+    point_t lo, hi;
+    tinfo.tiles.bounds(ginfo.height, ginfo.width, TILE_KNOWN, lo, hi);
+    if (lo != (point_t){ 0, 0 } or hi != (point_t){ ginfo.height, ginfo.width }) {
+        cerr << "rows " << lo.y << "-" << hi.y - 1 << ", cols " << lo.x << "-" << hi.x - 1 << endl;
+    }
+    repeat_from (y,lo.y,hi.y) {
+        repeat_from (x,lo.x,hi.x) {
             point_t q = { y, x };
             if (tinfo.field[y][x] == F_UNKNOWN) {
                 cerr << "\x1b[40m";
@@ -264,7 +585,10 @@ next:;
 }
 
 array<int,ENEMY_NUM> turns_to_next(turn_info_t const & tinfo) {
-    int turn = tinfo.turn % TURN_CYCLE;
+    return turns_to_next(tinfo.turn);
+}
+array<int,ENEMY_NUM> turns_to_next(int turn) {
+    turn %= TURN_CYCLE;
     int weapon = TURNS[turn];
     int side = weapon >= FRIEND_NUM;
     array<int,ENEMY_NUM> turns = {};
@@ -274,3 +598,18 @@ array<int,ENEMY_NUM> turns_to_next(turn_info_t const & tinfo) {
     }
     return turns;
 }
+array<int,ENEMY_NUM> turns_between(int from, int to) {
+    int side = TURNS[to % TURN_CYCLE] >= FRIEND_NUM;
+    array<int,ENEMY_NUM> turns = {};
+    repeat_from (t, max(0, from + 1), to) {
+        int i = TURNS[t % TURN_CYCLE];
+        if (side == 0 and FRIEND_NUM <= i) turns[i - FRIEND_NUM] += 1;
+        if (side == 1 and i <  FRIEND_NUM) turns[i] += 1;
+    }
+    return turns;
+}
+int next_turn(int turn) {
+    int next = turn + 1;
+    while (TURNS[next % TURN_CYCLE] != TURNS[turn % TURN_CYCLE]) ++ next;
+    return next;
+}
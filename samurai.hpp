@@ -16,7 +16,14 @@
 #include <unordered_map>
 #include <random>
 #include <cstdio>
+#include <cstdint>
 #include <cassert>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #define repeat(i,n) for (int i = 0; (i) < (n); ++(i))
 #define repeat_from(i,m,n) for (int i = (m); (i) < (n); ++(i))
 #define repeat_reverse(i,n) for (int i = (n)-1; (i) >= 0; --(i))
@@ -26,12 +33,29 @@
 typedef long long ll;
 const double eps = 1e-6;
 
-int getint(std::istream & in); // without comment
+/**
+ * reads integers from a file descriptor in large chunks, without allocation
+ * @note read(2) returns what is available, so this works on interactive pipes
+ */
+class scanner_t {
+    int fd;
+    int l, r;
+    bool eof, failed;
+    char buf[1 << 16];
+    bool fill();
+    int peek() { return (l < r or fill()) ? (unsigned char)buf[l] : EOF; }
+    bool skip(); // spaces and comments, returns false at the end of file
+public:
+    explicit scanner_t(int fd = 0);
+    int getint(); // without comment
+    int gettag(); // "@id" of the host protocol, -1 and fails if the next token is not a tag
+    explicit operator bool () const { return not failed; }
+};
 
 struct point_t {
     int y, x;
 };
-std::istream & operator >> (std::istream & in, point_t & p);
+scanner_t & operator >> (scanner_t & in, point_t & p);
 bool operator == (point_t const & a, point_t const & b);
 bool operator != (point_t const & a, point_t const & b);
 bool operator < (point_t const & a, point_t const & b);
@@ -45,6 +69,26 @@ point_t rotdir(point_t const & a, int direction);
 int manhattan_distance(point_t const & a, point_t const & b);
 const int DIRECTION_NUM = 4;
 
+/**
+ * a 2D grid in one contiguous block, rows are padded up to stride
+ */
+template <typename T>
+struct grid_t {
+    static const int ALIGN = 16;
+    int height, width, stride;
+    std::vector<T> data;
+    grid_t() : height(0), width(0), stride(0) {}
+    grid_t(int height, int width, T value = T())
+            : height(height), width(width), stride((width + ALIGN - 1) / ALIGN * ALIGN),
+              data(height * stride, value) {}
+    T       * operator [] (int y)       { return &data[y * stride]; }
+    T const * operator [] (int y) const { return &data[y * stride]; }
+    T       & operator [] (point_t const & p)       { return data[p.y * stride + p.x]; }
+    T const & operator [] (point_t const & p) const { return data[p.y * stride + p.x]; }
+    void fill(T value) { std::fill(data.begin(), data.end(), value); }
+    bool empty() const { return data.empty(); }
+};
+
 const int SAMURAI_NUM = 6;
 const int FRIEND_NUM = 3;
 const int ENEMY_NUM = 3;
@@ -60,7 +104,7 @@ struct game_info_t {
     int rank[6];
     int score[6];
 };
-std::istream & operator >> (std::istream & in, game_info_t & ginfo);
+scanner_t & operator >> (scanner_t & in, game_info_t & ginfo);
 
 // field state
 const int F_OCCUPIED = 0;
@@ -70,15 +114,143 @@ bool is_field_occupied(int f);
 bool is_field_friend(int f);
 bool is_field_enemy(int f);
 bool is_on_field(point_t const & p, game_info_t const & ginfo); 
+typedef grid_t<uint8_t> field_t; // a cell holds one of 0-9
+
+/**
+ * flags per tile of TILE x TILE cells, so that a pass over a large field visits only the tiles it needs
+ * @note an empty map has every flag on every tile, for a field whose tiles are not tracked
+ */
+const int TILE = 16; // equals grid_t::ALIGN, so a row of a tile is a word of SSE2
+const int TILE_KNOWN = 1; // has a cell which is not F_UNKNOWN, all of the others are F_UNKNOWN
+const int TILE_DIRTY = 2; // has a cell which has changed since the last clear
+struct tile_map_t {
+    int rows, cols;
+    std::vector<uint8_t> flags; // flags[ty * cols + tx]
+    tile_map_t() : rows(0), cols(0) {}
+    tile_map_t(int height, int width) : rows((height + TILE - 1) / TILE), cols((width + TILE - 1) / TILE), flags(rows * cols) {}
+    bool empty() const { return flags.empty(); }
+    bool has(int ty, int tx, int flag) const { return empty() or (flags[ty * cols + tx] & flag); }
+    void mark(point_t const & p, int flag) {
+        if (not empty()) flags[p.y / TILE * cols + p.x / TILE] |= flag;
+    }
+    void mark(int y0, int x0, int y1, int x1, int flag); // the tiles of the cells in [y0, y1) x [x0, x1), clipped
+    void clear(int flag) {
+        for (uint8_t & it : flags) it &= ~ flag;
+    }
+    void merge(tile_map_t const & other); // or, of the same size
+    void bounds(int height, int width, int flag, point_t & lo, point_t & hi) const; // the box [lo, hi) of the cells of the flagged tiles
+    // calls f(y, x0, x1) for each row of each run of the flagged tiles in row-major order, where x1 is a multiple of TILE up to the stride
+    template <typename F>
+    void for_each_segment(int height, int width, int flag, F f) const {
+        int n = (width + TILE - 1) / TILE;
+        assert (empty() or (rows == (height + TILE - 1) / TILE and cols == n));
+        repeat (ty, (height + TILE - 1) / TILE) {
+            bool any = false;
+            repeat (tx,n) if (has(ty, tx, flag)) { any = true; break; }
+            if (not any) continue;
+            repeat_from (y, ty * TILE, std::min(height, (ty + 1) * TILE)) {
+                for (int tx = 0; tx < n; ) {
+                    if (not has(ty, tx, flag)) { ++ tx; continue; }
+                    int tx0 = tx;
+                    while (tx < n and has(ty, tx, flag)) ++ tx;
+                    f(y, tx0 * TILE, tx * TILE);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * calls f(q) for each cell where a and b differ, in row-major order, except the cells where b is ignored (-1 ignores none)
+ * only the tiles with the flag are compared, so the cells out of them must be known to be the same
+ * @note compares 16 cells at once with SSE2 and 32 with AVX2, and masks out the padding of rows
+ */
+template <typename F>
+void for_each_changed_cell(field_t const & a, field_t const & b, int ignored, tile_map_t const & tiles, int flag, F f) {
+    assert (a.height == b.height and a.width == b.width);
+    auto visit = [&](int y, int x, uint32_t m) { // m has the bits of the changed cells from x
+        for (; m; m &= m - 1) {
+            int dx = x + __builtin_ctz(m);
+            if (dx >= a.width) break;
+            f((point_t){ y, dx });
+        }
+    };
+#ifdef __AVX2__
+    __m256i ignored32 = _mm256_set1_epi8(ignored);
+#endif
+#ifdef __SSE2__
+    __m128i ignored16 = _mm_set1_epi8(ignored);
+#endif
+    tiles.for_each_segment(a.height, a.width, flag, [&](int y, int x0, int x1) {
+        uint8_t const *ra = a[y];
+        uint8_t const *rb = b[y];
+        int x = x0;
+#ifdef __AVX2__
+        for (; x + 32 <= x1; x += 32) {
+            __m256i va = _mm256_loadu_si256((__m256i const *)(ra + x));
+            __m256i vb = _mm256_loadu_si256((__m256i const *)(rb + x));
+            __m256i same = _mm256_or_si256(_mm256_cmpeq_epi8(va, vb), _mm256_cmpeq_epi8(vb, ignored32));
+            visit(y, x, ~ uint32_t(_mm256_movemask_epi8(same)));
+        }
+#endif
+#ifdef __SSE2__
+        for (; x + 16 <= x1; x += 16) {
+            __m128i va = _mm_loadu_si128((__m128i const *)(ra + x));
+            __m128i vb = _mm_loadu_si128((__m128i const *)(rb + x));
+            __m128i same = _mm_or_si128(_mm_cmpeq_epi8(va, vb), _mm_cmpeq_epi8(vb, ignored16));
+            visit(y, x, ~ uint32_t(_mm_movemask_epi8(same)) & 0xffff);
+        }
+#endif
+        for (; x < std::min(x1, a.width); ++ x) {
+            if (ra[x] != rb[x] and rb[x] != uint8_t(ignored)) f((point_t){ y, x });
+        }
+    });
+}
+template <typename F>
+void for_each_changed_cell(field_t const & a, field_t const & b, int ignored, F f) {
+    for_each_changed_cell(a, b, ignored, tile_map_t(), 0, f);
+}
+void copy_tiles(field_t const & from, field_t & to, tile_map_t const & tiles, int flag); // all of from if the sizes differ
+// makes to equal to from, where each is F_UNKNOWN out of its TILE_KNOWN tiles, by copying only the known tiles of either
+void copy_known(field_t const & from, tile_map_t const & from_tiles, field_t & to, tile_map_t & to_tiles);
+
+/**
+ * a field which keeps its statistics up to date while cells change one by one
+ * @note the frontier is the free or unknown cells next to a friend cell
+ */
+class field_state_t {
+    field_t f;
+    std::array<int,F_UNKNOWN+1> counts; // counts[value] -> the number of cells
+    grid_t<uint8_t> friends; // the number of friend cells among the 4 neighbors
+    int frontier;
+    tile_map_t dirty; // TILE_DIRTY on the tiles set() has changed
+    friend class simulator_t; // which writes through set()
+public:
+    field_state_t() : counts(), frontier(0) {}
+    explicit field_state_t(field_t const & f);
+    field_t const & field() const { return f; }
+    uint8_t operator [] (point_t const & p) const { return f[p]; }
+    bool set(point_t const & p, int value); // returns whether the cell changes
+    int count(int value) const { return counts[value]; }
+    int territory(int side) const; // the cells of friends (side 0) or enemies (side 1)
+    bool is_frontier(point_t const & p) const {
+        return (f[p] == F_FREE or f[p] == F_UNKNOWN) and friends[p];
+    }
+    int frontier_size() const { return frontier; }
+    tile_map_t const & dirty_tiles() const { return dirty; }
+    void clean() { dirty.clear(TILE_DIRTY); }
+};
 
 struct turn_info_t {
     int turn; // ターンは 0 から番号付けされ、総ターン数未満である。
     int cure;
     point_t pos[6];
     int state[6];
-    std::vector<std::vector<int> > field;
+    field_t field;
+    tile_map_t tiles; // TILE_KNOWN of the field, empty if not computed
 };
-turn_info_t getturninfo(std::istream & in, game_info_t & ginfo);
+turn_info_t getturninfo(scanner_t & in, game_info_t const & ginfo);
+void update_turn_info(turn_info_t & to, turn_info_t const & from); // to = from, with copy_known() for the field
 
 // direction
 const int D_SOUTH = 0;
@@ -91,15 +263,189 @@ const int A_ATTACK = 1; // + direction
 const int A_MOVE   = 5; // + direction
 const int A_HIDE   = 9;
 const int A_APPEAR = 10;
-const int ACTION_COST[] = { -1,  4, 4, 4, 4,  2, 2, 2, 2,  1, 1 };
+constexpr int ACTION_COST[] = { -1,  4, 4, 4, 4,  2, 2, 2, 2,  1, 1 };
+const int ACTION_COST_LIMIT = 7;
 bool is_action_attack(int a);
 bool is_action_move(int a);
 
-const point_t ATTACK_AREA_SPEAR[] = { {1,0}, {2,0}, {3,0}, {4,0} };
-const point_t ATTACK_AREA_SWORD[] = { {0,2}, {0,1}, {1,1}, {1,0}, {2,0} };
-const point_t ATTACK_AREA_AXE[] = { {-1,1}, {0,1}, {1,1}, {1,0}, {1,-1}, {0,-1}, {-1,-1} };
-const point_t * const ATTACK_AREA[] = { ATTACK_AREA_SPEAR, ATTACK_AREA_SWORD, ATTACK_AREA_AXE };
-const int ATTACK_AREA_NUM[] = { 4, 5, 7 };
+constexpr point_t ATTACK_AREA_SPEAR[] = { {1,0}, {2,0}, {3,0}, {4,0} };
+constexpr point_t ATTACK_AREA_SWORD[] = { {0,2}, {0,1}, {1,1}, {1,0}, {2,0} };
+constexpr point_t ATTACK_AREA_AXE[] = { {-1,1}, {0,1}, {1,1}, {1,0}, {1,-1}, {0,-1}, {-1,-1} };
+constexpr point_t const * ATTACK_AREA[] = { ATTACK_AREA_SPEAR, ATTACK_AREA_SWORD, ATTACK_AREA_AXE };
+constexpr int ATTACK_AREA_NUM[] = { 4, 5, 7 };
+const int ATTACK_AREA_MAX = 7;
+const int ATTACK_REACH = 4; // the largest |dy| or |dx| in the areas
+constexpr int constexpr_abs(int a) { return a < 0 ? - a : a; }
+constexpr int constexpr_max(int a, int b) { return a < b ? b : a; }
+constexpr int attack_reach(int weapon, int i = 0) { // ATTACK_REACH of the weapon
+    return i == ATTACK_AREA_NUM[weapon] ? 0 :
+        constexpr_max(constexpr_max(constexpr_abs(ATTACK_AREA[weapon][i].y), constexpr_abs(ATTACK_AREA[weapon][i].x)), attack_reach(weapon, i + 1));
+}
+constexpr point_t rotate(point_t const & p, int direction) { // rotdir() at compile time
+    return direction == 0 ? p :
+           direction == 1 ? (point_t){ - p.x,   p.y } :
+           direction == 2 ? (point_t){ - p.y, - p.x } :
+                            (point_t){   p.x, - p.y };
+}
+
+/**
+ * an attack area rotated to a direction, with the clipping at the board edges precomputed
+ */
+struct footprint_t {
+    int size;
+    point_t offset[ATTACK_AREA_MAX];
+    // bit i is set iff offset[i] stays on the field, indexed by [min(y, reach)][min(height-1-y, reach)]
+    uint8_t row_mask[ATTACK_REACH+1][ATTACK_REACH+1];
+    uint8_t col_mask[ATTACK_REACH+1][ATTACK_REACH+1];
+    int mask(point_t const & p, game_info_t const & ginfo) const {
+        return row_mask[std::min(p.y, ATTACK_REACH)][std::min(ginfo.height-1 - p.y, ATTACK_REACH)]
+             & col_mask[std::min(p.x, ATTACK_REACH)][std::min(ginfo.width -1 - p.x, ATTACK_REACH)];
+    }
+};
+footprint_t const & footprint(int weapon, int direction);
+// the attack area of the weapon W in the direction D from the index I, unrolled into straight-line code
+template <int W, int D, int I = 0, bool END = (I == ATTACK_AREA_NUM[W])>
+struct attack_kernel_t {
+    template <typename F>
+    static void run(point_t const & p, F & f) {
+        constexpr point_t o = rotate(ATTACK_AREA[W][I], D);
+        f((point_t){ p.y + o.y, p.x + o.x });
+        attack_kernel_t<W,D,I+1>::run(p, f);
+    }
+};
+template <int W, int D, int I>
+struct attack_kernel_t<W,D,I,true> {
+    template <typename F>
+    static void run(point_t const &, F &) {}
+};
+// calls f(q) for each cell on the field which is attacked from p, in the order of ATTACK_AREA
+template <int W, typename F>
+void for_each_attacked(int direction, point_t const & p, game_info_t const & ginfo, F f) {
+    const int r = attack_reach(W);
+    if (r <= p.y and p.y < ginfo.height - r and r <= p.x and p.x < ginfo.width - r) { // nothing is clipped
+        switch (direction) {
+            case 0: attack_kernel_t<W,0>::run(p, f); break;
+            case 1: attack_kernel_t<W,1>::run(p, f); break;
+            case 2: attack_kernel_t<W,2>::run(p, f); break;
+            case 3: attack_kernel_t<W,3>::run(p, f); break;
+        }
+    } else {
+        footprint_t const & fp = footprint(W, direction);
+        for (int m = fp.mask(p, ginfo); m; m &= m - 1) {
+            f(p + fp.offset[__builtin_ctz(m)]);
+        }
+    }
+}
+// the weapon is constant through a game, so the branch is always predicted
+template <typename F>
+void for_each_attacked(int weapon, int direction, point_t const & p, game_info_t const & ginfo, F f) {
+    switch (weapon) {
+        case 0: for_each_attacked<0>(direction, p, ginfo, f); break;
+        case 1: for_each_attacked<1>(direction, p, ginfo, f); break;
+        case 2: for_each_attacked<2>(direction, p, ginfo, f); break;
+    }
+}
+void occupy(field_t & f, int weapon, int direction, point_t const & p, game_info_t const & ginfo);
+std::vector<point_t> const & attack_stencil(int weapon); // the union of the footprints of all directions
+struct attacker_t {
+    int direction;
+    point_t offset; // the attack in the direction from q - offset covers q
+};
+std::vector<attacker_t> const & inverse_footprint(int weapon); // the cells of all footprints of the weapon
+// calls f(p, direction) for each origin p on the field whose attack in the direction covers q
+template <typename F>
+void for_each_attacker(int weapon, point_t const & q, game_info_t const & ginfo, F f) {
+    for (attacker_t const & it : inverse_footprint(weapon)) {
+        point_t p = { q.y - it.offset.y, q.x - it.offset.x };
+        if (is_on_field(p, ginfo)) f(p, it.direction);
+    }
+}
+
+/**
+ * which of the estimated positions of an enemy threaten each cell, as a bitset per cell
+ */
+class danger_map_t {
+    int height, width, words;
+    std::vector<uint64_t> bits; // bits[(y * width + x) * words + k / 64] >> (k % 64) & 1 -> origins[k] threatens (y, x)
+    tile_map_t written; // TILE_DIRTY on the tiles which may have bits, so that the next build clears only them
+public:
+    danger_map_t() : height(0), width(0), words(0) {}
+    // an enemy at origins[k] may move within the square of range, and then attack
+    void build(int weapon, std::vector<point_t> const & origins, int range, game_info_t const & ginfo);
+    int size() const { return words; } // in words
+    uint64_t const * at(point_t const & p) const { return bits.data() + (p.y * width + p.x) * words; }
+    bool any(point_t const & p) const {
+        repeat (i,words) if (at(p)[i]) return true;
+        return false;
+    }
+    // calls f(k) for each origin k which threatens p and is not excluded
+    template <typename F>
+    void for_each_excluding(point_t const & p, uint64_t const * excluded, F f) const {
+        repeat (i,words) {
+            for (uint64_t m = at(p)[i] & ~ excluded[i]; m; m &= m - 1) {
+                f(i * 64 + __builtin_ctzll(m));
+            }
+        }
+    }
+};
+
+/**
+ * the number of the cells which satisfy a predicate in any rectangle, in O(1) after an O(HW) build
+ * @note a build over a window of the board counts only the cells in the window
+ */
+class summed_area_t {
+    int top, left, height, width; // the window
+    std::vector<int> s; // s[y * (width + 1) + x] -> the number in [top, top + y) x [left, left + x)
+public:
+    summed_area_t() : top(0), left(0), height(0), width(0) {}
+    template <typename F>
+    summed_area_t(int height, int width, F pred) { build(height, width, pred); }
+    template <typename F>
+    void build(int height, int width, F pred) { build(0, 0, height, width, pred); }
+    template <typename F>
+    void build(int y0, int x0, int y1, int x1, F pred) { // of [y0, y1) x [x0, x1), and reuses the memory
+        top = y0;
+        left = x0;
+        height = y1 - y0;
+        width = x1 - x0;
+        s.assign((height + 1) * (width + 1), 0);
+        repeat (y,height) repeat (x,width) {
+            s[(y+1) * (width+1) + x+1] = s[y * (width+1) + x+1] + s[(y+1) * (width+1) + x] - s[y * (width+1) + x]
+                + bool(pred((point_t){ top + y, left + x }));
+        }
+    }
+    // in [y0, y1) x [x0, x1), clipped to the window
+    int count(int y0, int x0, int y1, int x1) const {
+        y0 = std::max(y0 - top, 0); y1 = std::min(y1 - top, height);
+        x0 = std::max(x0 - left, 0); x1 = std::min(x1 - left, width);
+        if (y0 >= y1 or x0 >= x1) return 0;
+        return s[y1 * (width+1) + x1] - s[y0 * (width+1) + x1] - s[y1 * (width+1) + x0] + s[y0 * (width+1) + x0];
+    }
+};
+
+// the number of moves from each cell to the nearest source, stepping only onto passable cells or the sources, -1 if unreachable
+template <typename S, typename P>
+grid_t<int> distance_field(game_info_t const & ginfo, S is_source, P is_passable) {
+    grid_t<int> dist(ginfo.height, ginfo.width, -1);
+    std::vector<point_t> que;
+    repeat (y,ginfo.height) repeat (x,ginfo.width) {
+        point_t p = { y, x };
+        if (is_source(p)) {
+            dist[p] = 0;
+            que.push_back(p);
+        }
+    }
+    repeat (i,int(que.size())) { // the queue only grows
+        point_t q = que[i];
+        repeat (d,4) {
+            point_t p = q - direction[d];
+            if (not is_on_field(p, ginfo) or dist[p] != -1 or not is_passable(p)) continue;
+            dist[p] = dist[q] + 1;
+            que.push_back(p);
+        }
+    }
+    return dist;
+}
 
 // state
 const int S_APPEARED = 0;
@@ -113,13 +459,93 @@ std::ostream & operator << (std::ostream & out, action_plan_t & plan);
 int total_cost(action_plan_t const & plan);
 point_t total_move(action_plan_t const & plan);
 bool is_valid_plan(action_plan_t const & plan, game_info_t const & ginfo, turn_info_t const & tinfo);
-std::vector<std::vector<int> > simulate_plan(action_plan_t const & plan, std::vector<std::vector<int> > f, point_t p, game_info_t const & ginfo);
+field_t simulate_plan(action_plan_t const & plan, field_t f, point_t p, game_info_t const & ginfo);
+
+// keys of zobrist hashing, computed instead of looked up so that any size of board works
+// a value packs its fields in separate 32 bit halves, so the fields do not overlap even on a large board
+const int Z_CELL = 0; // y << 32 | x, a cell which has become ours
+const int Z_POS = 1; // y << 32 | x
+const int Z_STATE = 2;
+const int Z_KILLED = 3; // enemy id << 32 | the index of the estimated position
+const int Z_TURN = 4;
+const int Z_PLY = 5;
+const int Z_FROM = 6; // y << 32 | x, where the search of a ply starts
+inline uint64_t yx_key(point_t const & p) { return uint64_t(uint32_t(p.y)) << 32 | uint32_t(p.x); }
+inline uint64_t zobrist_key(int kind, uint64_t value) {
+    // splitmix64, whose counter starts at each kind, so the kind does not share bits with the value
+    uint64_t z = value + uint64_t(kind + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * applies actions one by one onto a shared field, checking the rules on the way, and rolls them back
+ * @note the field is borrowed, it is restored after undo_all()
+ */
+class simulator_t {
+public:
+    static const int MAX_ACTIONS = 7; // every action costs at least 1
+    static const int MAX_CHANGES = MAX_ACTIONS * 7;
+    struct change_t { point_t q; uint8_t prv; };
+private:
+    struct frame_t { int a; point_t p; int s; int cost; int changes; uint64_t hash; };
+    game_info_t const & ginfo;
+    turn_info_t const & tinfo;
+    field_t & f;
+    field_state_t *fs; // f is fs->f if not null
+    void write(point_t const & q, uint8_t value) {
+        if (fs) fs->set(q, value); else f[q] = value;
+    }
+    point_t p;
+    int s;
+    int c;
+    uint64_t h;
+    int frame_size, change_size;
+    std::array<frame_t,MAX_ACTIONS> frames;
+    std::array<change_t,MAX_CHANGES> changes;
+public:
+    simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_t & f);
+    simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_t & f, point_t const & p, int s); // starts from p and s instead of tinfo
+    simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_state_t & fs); // keeps the statistics of fs
+    simulator_t(game_info_t const & ginfo, turn_info_t const & tinfo, field_state_t & fs, point_t const & p, int s);
+    bool apply(int a); // returns false and changes nothing if the action is invalid
+    int apply(action_plan_t const & plan); // returns the length of the valid prefix
+    void undo();
+    void undo_all();
+    field_t const & field() const { return f; }
+    point_t pos() const { return p; }
+    int state() const { return s; }
+    int cost() const { return c; }
+    uint64_t hash() const { return h; } // the xor of zobrist_key(Z_CELL, ...) of the cells which have become ours
+    int size() const { return frame_size; }
+    // cells written by the last action, with their previous values
+    change_t const * last_changes_begin() const { return changes.data() + (frame_size ? frames[frame_size-1].changes : 0); }
+    change_t const * last_changes_end() const { return changes.data() + change_size; }
+};
+
 
+/**
+ * every action sequence whose total cost is within the limit, with common prefixes merged
+ * @note nodes are in preorder: the children of i are i+1, i+1+size, ... up to i+size, and the root is the empty plan
+ */
+struct action_trie_node_t {
+    int a; // the last action
+    int size; // the number of nodes in the subtree, including itself
+};
+constexpr int action_trie_size(int budget, int a = A_ATTACK) {
+    return a > A_APPEAR ? 1 : (ACTION_COST[a] <= budget ? action_trie_size(budget - ACTION_COST[a]) : 0) + action_trie_size(budget, a + 1);
+}
+const int ACTION_TRIE_SIZE = action_trie_size(ACTION_COST_LIMIT);
+extern const std::array<action_trie_node_t,ACTION_TRIE_SIZE> ACTION_TRIE;
 
-void debug_print(point_t const & p, std::vector<std::vector<int> > const & field, game_info_t const & ginfo, turn_info_t const & tinfo);
+void debug_print(point_t const & p, field_t const & field, game_info_t const & ginfo, turn_info_t const & tinfo);
 
 // サムライが行動する順序は以下の 12 ターンの繰り返しとする。
 // A0 B0 B1 A1 A2 B2 B0 A0 A1 B1 B2 A2
 const int TURN_CYCLE = 12;
 const int TURNS[TURN_CYCLE] = { 0,3,4,1,2,5, 3,0,1,4,5,2 };
+std::array<int,ENEMY_NUM> turns_to_next(int turn);
 std::array<int,ENEMY_NUM> turns_to_next(turn_info_t const & tinfo);
+std::array<int,ENEMY_NUM> turns_between(int from, int to); // the turns of the enemies of the samurai of the turn to, in (from, to)
+int next_turn(int turn); // the next turn of the samurai who acts in the turn
@@ -0,0 +1,106 @@
+/**
+ * @file selfplay.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief plays many games between two configurations of player in process, and reports the results
+ * @note usage: ./selfplay.out [-n games] [-j threads] [-t seconds per game] [-w width] [-d depth] [-f frontier weight]
+ *     the candidate gets -w, -d and -f, and plays the side 0 in the even games and the side 1 in the odd ones
+ */
+#include "player.hpp"
+#include "engine.hpp"
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+struct game_result_t {
+    array<int,2> territory; // [0] is the candidate
+    array<int,2> injured;
+    vector<double> latencies; // seconds per call of player::play
+};
+
+game_result_t play_game(int game, search_config_t const & candidate, search_config_t const & baseline) {
+    typedef chrono::steady_clock clock;
+    engine_t engine(engine_t::default_game_info());
+    int candidate_side = game % 2;
+    vector<unique_ptr<player> > players;
+    repeat (i,SAMURAI_NUM) {
+        int side = i / FRIEND_NUM;
+        players.emplace_back(new player(engine.view_game_info(i), side == candidate_side ? candidate : baseline));
+    }
+    game_result_t result;
+    while (not engine.is_over()) {
+        int i = engine.current_samurai();
+        turn_info_t tinfo = engine.view_turn_info(i);
+        clock::time_point begin = clock::now();
+        action_plan_t plan = players[i]->play(tinfo);
+        result.latencies.push_back(chrono::duration<double>(clock::now() - begin).count());
+        engine.play(plan);
+    }
+    array<int,2> territory = engine.territory();
+    repeat (side,2) {
+        int k = side == candidate_side ? 0 : 1;
+        result.territory[k] = territory[side];
+        result.injured[k] = engine.injured(side);
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    int games = 100;
+    int threads = 0;
+    search_config_t baseline = DEFAULT_SEARCH_CONFIG;
+    baseline.time_limit = 1.0;
+    baseline.threads = 1;
+    baseline.verbose = false;
+    search_config_t candidate = baseline;
+    repeat_from (i,1,argc) {
+        if (i + 1 == argc) {
+            cerr << "missing argument: " << argv[i] << endl;
+            return 1;
+        }
+        const char *arg = argv[++ i];
+        if      (not strcmp(argv[i-1], "-n")) games = atoi(arg);
+        else if (not strcmp(argv[i-1], "-j")) threads = atoi(arg);
+        else if (not strcmp(argv[i-1], "-t")) baseline.time_limit = candidate.time_limit = atof(arg);
+        else if (not strcmp(argv[i-1], "-w")) candidate.width = atoi(arg);
+        else if (not strcmp(argv[i-1], "-d")) candidate.depth = atoi(arg);
+        else if (not strcmp(argv[i-1], "-f")) candidate.frontier_weight = atof(arg);
+        else {
+            cerr << "unknown option: " << argv[i-1] << endl;
+            return 1;
+        }
+    }
+
+    thread_pool_t pool(threads);
+    vector<game_result_t> results(games);
+    pool.run(games, [&](int game, int) {
+        results[game] = play_game(game, candidate, baseline);
+    });
+
+    int win = 0, draw = 0, lose = 0;
+    double diff = 0;
+    array<double,2> injured = {};
+    vector<double> latencies;
+    for (game_result_t const & it : results) {
+        int d = it.territory[0] - it.territory[1];
+        (d > 0 ? win : d < 0 ? lose : draw) += 1;
+        diff += d;
+        repeat (k,2) injured[k] += it.injured[k];
+        latencies.insert(latencies.end(), it.latencies.begin(), it.latencies.end());
+    }
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies.empty() ? 0 : latencies[min<int>(latencies.size() - 1, p * latencies.size())]; };
+    double mean = 0;
+    for (double it : latencies) mean += it;
+    if (not latencies.empty()) mean /= latencies.size();
+    games = max(1, games);
+    cout << "games: " << results.size() << " (on " << pool.size() << " threads)" << endl;
+    cout << "candidate: win " << win << " / draw " << draw << " / lose " << lose
+         << ", win rate " << (win + 0.5 * draw) / games << endl;
+    cout << "territory diff: " << diff / games << " per game" << endl;
+    cout << "injured: " << injured[0] / games << " by the candidate, " << injured[1] / games << " by the baseline, per game" << endl;
+    cout << "latency: mean " << mean * 1000 << " ms, p50 " << percentile(0.5) * 1000 << " ms, p99 " << percentile(0.99) * 1000
+         << " ms, max " << (latencies.empty() ? 0 : latencies.back()) * 1000 << " ms" << endl;
+    INSTRUMENT_FLUSH(cerr);
+    return 0;
+}
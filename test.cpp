@@ -0,0 +1,161 @@
+/**
+ * @file test.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief checks the behaviors which the games do not show easily
+ * @note usage: ./test.out, prints the failed checks and exits with 1 if any
+ */
+#include "player.hpp"
+#include "engine.hpp"
+#include "record.hpp"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+using namespace std;
+
+static int failures = 0;
+#define check(cond) do { if (not (cond)) { cerr << __FILE__ << ":" << __LINE__ << ": failed: " << #cond << endl; ++ failures; } } while (false)
+
+/**
+ * drives the private phases of player
+ */
+struct player_probe_t {
+    // beam_search() on the turn info, with the enemy 0 estimated at the one position
+    static double beam_search(player & p, turn_info_t const & tinfo, point_t const & enemy, int depth) {
+        p.timer.start();
+        p.timer.set_budget(1);
+        p.arena.reset();
+        p.tinfo = tinfo;
+        p.update();
+        p.eposs[0].assign(1, enemy);
+        p.eweights[0].assign(1, 1);
+        p.is_dangerous_ready = 0;
+        action_plan_t plan;
+        double score = - INFINITY, first;
+        p.beam_search(depth, plan, score, first);
+        return score;
+    }
+};
+
+// a kill in our turn removes the danger of the enemy in our next turn too
+void test_kill_removes_later_danger() {
+    game_info_t ginfo = engine_t::default_game_info(9); // small enough that we cannot run out of its reach
+    search_config_t config = DEFAULT_SEARCH_CONFIG;
+    config.threads = 1;
+    config.verbose = false;
+    config.time_limit = config.turn_time_limit = 1e9;
+    turn_info_t tinfo = {};
+    tinfo.turn = 0;
+    repeat (i,SAMURAI_NUM) {
+        tinfo.pos[i] = ginfo.home[i];
+        tinfo.state[i] = S_APPEARED;
+    }
+    tinfo.pos[0] = (point_t){ 2, 2 }; // the spear
+    tinfo.pos[FRIEND_NUM] = (point_t){ -1, -1 };
+    tinfo.state[FRIEND_NUM] = S_HIDDEN;
+    tinfo.field = field_t(ginfo.height, ginfo.width, F_FREE);
+    point_t enemy = { 4, 2 }; // in the attack to the south
+    player p1(ginfo, config);
+    double one = player_probe_t::beam_search(p1, tinfo, enemy, 1);
+    player p2(ginfo, config);
+    double two = player_probe_t::beam_search(p2, tinfo, enemy, 2);
+    check (one > 100000); // the kill
+    check (two > one); // the next turn adds no danger of the killed enemy
+}
+
+// the bytes of a record of a few turns on the free field, and the field of them
+vector<char> make_record(field_t & field) {
+    game_info_t ginfo = engine_t::default_game_info(15);
+    turn_info_t tinfo = {};
+    repeat (i,SAMURAI_NUM) {
+        tinfo.pos[i] = ginfo.home[i];
+        tinfo.state[i] = S_APPEARED;
+    }
+    tinfo.field = field_t(ginfo.height, ginfo.width, F_FREE);
+    tinfo.field[3][4] = F_UNKNOWN;
+    field = tinfo.field;
+    char path[] = "/tmp/test.rec.XXXXXX";
+    close(mkstemp(path));
+    {
+        record_writer_t writer(path, ginfo);
+        repeat (t,3) {
+            tinfo.turn = t;
+            writer.push(tinfo, action_plan_t());
+        }
+    }
+    ifstream in(path, ios::binary);
+    vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    unlink(path);
+    return bytes;
+}
+// opens the bytes as a record
+bool open_record(record_reader_t & record, vector<char> const & bytes) {
+    char path[] = "/tmp/test.rec.XXXXXX";
+    int fd = mkstemp(path);
+    bool written = write(fd, bytes.data(), bytes.size()) == ssize_t(bytes.size());
+    close(fd);
+    bool opened = written and record.open(path);
+    unlink(path); // the mapping stays
+    return opened;
+}
+
+// a truncated record keeps the whole turns, and drops the rest
+void test_record_truncated() {
+    field_t field;
+    vector<char> bytes = make_record(field);
+    record_reader_t record;
+    check (open_record(record, bytes));
+    check (record.size() == 3);
+    bytes.resize(bytes.size() - sizeof(record_footer_t) - 3 * sizeof(uint64_t) - 1); // in the last turn
+    check (open_record(record, bytes));
+    check (record.size() == 2);
+    if (record.size() == 2) {
+        turn_info_t tinfo = record.turn_info(1);
+        check (tinfo.turn == 1);
+        bool same = tinfo.field.height == field.height and tinfo.field.width == field.width;
+        if (same) repeat (y,field.height) repeat (x,field.width) same = same and tinfo.field[y][x] == field[y][x];
+        check (same);
+    }
+}
+
+// a record of an empty or a huge field, or of a field which does not match the dimensions, is rejected
+void test_record_bad_dimension() {
+    field_t field;
+    vector<char> bytes = make_record(field);
+    record_reader_t record;
+    for (int32_t height : { 0, -1, 1 << 16, 14, 16 }) {
+        vector<char> broken = bytes;
+        memcpy(broken.data() + offsetof(record_header_t, height), &height, sizeof(height));
+        check (not open_record(record, broken));
+    }
+    vector<char> broken = bytes;
+    int32_t width = 0;
+    memcpy(broken.data() + offsetof(record_header_t, width), &width, sizeof(width));
+    check (not open_record(record, broken));
+}
+
+// a record with a value which is not of a cell is rejected
+void test_record_bad_value() {
+    field_t field;
+    vector<char> bytes = make_record(field);
+    record_reader_t record;
+    vector<char> broken = bytes;
+    char & cell = broken[sizeof(record_header_t) + sizeof(record_turn_t)]; // of the first turn
+    cell = (cell & 0xf0) | 0xf;
+    check (not open_record(record, broken));
+}
+
+int main() {
+    test_kill_removes_later_danger();
+    test_record_truncated();
+    test_record_bad_dimension();
+    test_record_bad_value();
+    if (failures) {
+        cerr << failures << " failed" << endl;
+        return 1;
+    }
+    cerr << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file util.cpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ */
+#include "util.hpp"
+using namespace std;
+
+time_manager_t::time_manager_t(double total, double turn_limit) : total(total), turn_limit(turn_limit), used(0) {
+    begin = deadline = clock::now();
+}
+void time_manager_t::start() {
+    begin = deadline = clock::now();
+}
+void time_manager_t::set_budget(int turns_left, double weight) {
+    double budget = remaining() / max(1, turns_left) * weight;
+    budget = max(0.0, min(budget, min(turn_limit, remaining())));
+    deadline = begin + chrono::duration_cast<clock::duration>(chrono::duration<double>(budget));
+}
+void time_manager_t::stop() {
+    used += elapsed();
+}
+double time_manager_t::elapsed() const {
+    return chrono::duration<double>(clock::now() - begin).count();
+}
+double time_manager_t::remaining() const {
+    return total - used;
+}
+
+#ifdef INSTRUMENT
+instrument_ring_t & instrument_ring() {
+    static instrument_ring_t ring;
+    return ring;
+}
+void instrument_ring_t::flush(ostream & out) {
+    uint64_t n = head.exchange(0);
+    struct summary_t { int count; double sum, max; };
+    map<string,summary_t> summaries; // by name, not by the pointer, since a literal may be duplicated
+    for (uint64_t i = n - min<uint64_t>(n, SIZE); i < n; ++ i) {
+        event_t const & e = events[i % SIZE];
+        summary_t & s = summaries[e.name];
+        s.max = s.count ? max(s.max, e.value) : e.value;
+        s.count += 1;
+        s.sum += e.value;
+    }
+    if (n > SIZE) out << "# instrument: " << n - SIZE << " events overwritten\n";
+    for (auto const & it : summaries) {
+        summary_t const & s = it.second;
+        out << "# instrument: " << it.first << ": count " << s.count << ", sum " << s.sum
+            << ", mean " << s.sum / s.count << ", max " << s.max << '\n';
+    }
+    out.flush();
+}
+#endif
+
+history_t::history_t(int capacity, int period) : capacity(capacity), period(period), since_snapshot(0) {
+    assert (capacity >= 1 and period >= 1);
+}
+void history_t::push(turn_info_t const & tinfo) {
+    entries.emplace_back();
+    entry_t & e = entries.back();
+    e.tinfo.turn = tinfo.turn;
+    e.tinfo.cure = tinfo.cure;
+    repeat (i,SAMURAI_NUM) {
+        e.tinfo.pos[i] = tinfo.pos[i];
+        e.tinfo.state[i] = tinfo.state[i];
+    }
+    e.tinfo.tiles = tinfo.tiles;
+    if (entries.size() == 1 or since_snapshot + 1 >= period or last.field.width != tinfo.field.width or last.field.height != tinfo.field.height) {
+        e.tinfo.field = tinfo.field;
+        since_snapshot = 0;
+    } else {
+        // the cells out of the known tiles of both are F_UNKNOWN in both
+        compared = last.tiles;
+        compared.merge(tinfo.tiles);
+        for_each_changed_cell(last.field, tinfo.field, -1, compared, TILE_KNOWN, [&](point_t const & q) {
+            e.changes.push_back((change_t){ q.y * tinfo.field.stride + q.x, tinfo.field[q] });
+        });
+        since_snapshot += 1;
+    }
+    update_turn_info(last, tinfo);
+    if (int(entries.size()) > capacity) {
+        // the next one becomes the oldest, so it needs its own field
+        if (entries[1].tinfo.field.empty()) {
+            entries[1].tinfo.field = field_at(1);
+            entries[1].changes.clear();
+            entries[1].changes.shrink_to_fit();
+        }
+        entries.pop_front();
+    }
+}
+field_t history_t::field_at(int i) const {
+    int j = i;
+    while (entries[j].tinfo.field.empty()) -- j;
+    field_t f = entries[j].tinfo.field;
+    repeat_from (k,j+1,i+1) {
+        for (change_t const & it : entries[k].changes) f.data[it.index] = it.value;
+    }
+    return f;
+}
+turn_info_t history_t::at(int i) const {
+    assert (0 <= i and i < size());
+    turn_info_t tinfo = entries[i].tinfo;
+    if (tinfo.field.empty()) tinfo.field = field_at(i);
+    return tinfo;
+}
+int history_t::find(int turn) const {
+    repeat (i,size()) if (entries[i].tinfo.turn == turn) return i;
+    return -1;
+}
+
+thread_pool_t::thread_pool_t(int size) : job_size(0), next(0), generation(0), running(0), quit(false) {
+    if (size <= 0) size = max<int>(1, thread::hardware_concurrency());
+    repeat_from (i,1,size) threads.emplace_back(&thread_pool_t::work, this, i);
+}
+thread_pool_t::~thread_pool_t() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (thread & it : threads) it.join();
+}
+void thread_pool_t::work(int worker) {
+    int seen = 0;
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return quit or generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        drain(worker);
+        {
+            lock_guard<std::mutex> lock(mutex);
+            if (-- running == 0) done.notify_all();
+        }
+    }
+}
+void thread_pool_t::drain(int worker) {
+    for (int i = next ++; i < job_size; i = next ++) {
+        job(i, worker);
+    }
+}
+void thread_pool_t::run(int n, function<void (int, int)> const & f) {
+    if (threads.empty()) {
+        repeat (i,n) f(i, 0);
+        return;
+    }
+    {
+        lock_guard<std::mutex> lock(mutex);
+        job = f;
+        job_size = n;
+        next = 0;
+        running = threads.size();
+        ++ generation;
+    }
+    wake.notify_all();
+    drain(0);
+    unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return running == 0; });
+}
+
+arena_t::arena_t(size_t size) : current(0), used(0) {
+    blocks.push_back((block_t){ unique_ptr<char[]>(new char[size]), size });
+}
+void *arena_t::allocate(size_t n, size_t align) {
+    while (true) {
+        block_t & b = blocks[current];
+        size_t offset = (used + align - 1) / align * align; // new[] aligns the block enough
+        if (offset + n <= b.size) {
+            used = offset + n;
+            return b.data.get() + offset;
+        }
+        if (current + 1 == blocks.size()) {
+            size_t size = max(2 * b.size, n + align);
+            blocks.push_back((block_t){ unique_ptr<char[]>(new char[size]), size });
+        }
+        ++ current;
+        used = 0;
+    }
+}
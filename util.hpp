@@ -0,0 +1,172 @@
+/**
+ * @file util.hpp
+ * @author Kimiyuki Onaka
+ * @date Tue. 05, 2016
+ * @brief the runtime of the player, apart from the rules in samurai.hpp
+ */
+#pragma once
+#include "samurai.hpp"
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+
+/**
+ * adds the seconds of its lifetime to a counter
+ */
+class stopwatch_t {
+    double & acc;
+    std::chrono::steady_clock::time_point begin;
+public:
+    explicit stopwatch_t(double & acc) : acc(acc), begin(std::chrono::steady_clock::now()) {}
+    ~stopwatch_t() { acc += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); }
+};
+
+/**
+ * instrumentation, compiled in only with -DINSTRUMENT
+ * INSTRUMENT_VALUE(name, value) records a sample, INSTRUMENT_COUNT(name) records 1,
+ * INSTRUMENT_TIMER(name) records the seconds until the end of the scope, and INSTRUMENT_FLUSH(out) prints the summary of each name
+ * @note the name must be a string literal, since events keep the pointer
+ */
+#ifdef INSTRUMENT
+class instrument_ring_t {
+public:
+    static const int SIZE = 1 << 16; // the older events are overwritten
+    struct event_t { char const *name; double value; };
+private:
+    std::array<event_t,SIZE> events;
+    std::atomic<uint64_t> head;
+public:
+    instrument_ring_t() : head(0) {}
+    void push(char const *name, double value) { // lock-free, from any thread
+        uint64_t i = head.fetch_add(1, std::memory_order_relaxed);
+        events[i % SIZE] = (event_t){ name, value };
+    }
+    void flush(std::ostream & out); // prints and forgets the events, while nobody pushes
+};
+instrument_ring_t & instrument_ring();
+class instrument_timer_t {
+    typedef std::chrono::steady_clock clock;
+    char const *name;
+    clock::time_point begin;
+public:
+    explicit instrument_timer_t(char const *name) : name(name), begin(clock::now()) {}
+    ~instrument_timer_t() { instrument_ring().push(name, std::chrono::duration<double>(clock::now() - begin).count()); }
+};
+#define INSTRUMENT_CONCAT_(a,b) a##b
+#define INSTRUMENT_CONCAT(a,b) INSTRUMENT_CONCAT_(a,b)
+#define INSTRUMENT_VALUE(name, value) instrument_ring().push((name), (value))
+#define INSTRUMENT_COUNT(name) INSTRUMENT_VALUE(name, 1)
+#define INSTRUMENT_TIMER(name) instrument_timer_t INSTRUMENT_CONCAT(instrument_timer_, __LINE__)(name)
+#define INSTRUMENT_FLUSH(out) instrument_ring().flush(out)
+#else
+#define INSTRUMENT_VALUE(name, value) ((void)0)
+#define INSTRUMENT_COUNT(name) ((void)0)
+#define INSTRUMENT_TIMER(name) ((void)0)
+#define INSTRUMENT_FLUSH(out) ((void)0)
+#endif
+
+/**
+ * splits the thinking time of a whole game into our turns
+ */
+class time_manager_t {
+    typedef std::chrono::steady_clock clock;
+    double total; // seconds for the game
+    double turn_limit; // seconds at most for a turn
+    double used;
+    clock::time_point begin, deadline;
+public:
+    time_manager_t(double total, double turn_limit);
+    void start();
+    void set_budget(int turns_left, double weight = 1); // turns_left includes this turn, and weight > 1 asks for more than the share
+    void stop();
+    double elapsed() const; // in this turn
+    double remaining() const; // for the game
+    bool is_over() const { return clock::now() >= deadline; }
+};
+
+/**
+ * the recent turn infos, kept as a full field every period entries and the changed cells between them
+ * @note at most capacity entries are kept, the older ones are forgotten
+ */
+class history_t {
+    struct change_t { int index; uint8_t value; }; // index in field_t::data
+    struct entry_t {
+        turn_info_t tinfo; // the field is empty unless the entry is a snapshot
+        std::vector<change_t> changes; // from the previous entry, unless a snapshot
+    };
+    int capacity, period;
+    int since_snapshot; // the number of entries pushed after the last snapshot
+    std::deque<entry_t> entries;
+    turn_info_t last;
+    tile_map_t compared; // the scratch of push()
+    field_t field_at(int i) const;
+public:
+    explicit history_t(int capacity = 16, int period = 8);
+    void push(turn_info_t const & tinfo);
+    int size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    turn_info_t const & back() const { return last; }
+    turn_info_t at(int i) const; // the i-th oldest entry, rebuilt from the nearest snapshot
+    int find(int turn) const; // the index of the entry of the turn, or -1
+};
+
+/**
+ * runs jobs of a parallel loop on a fixed set of threads
+ * @note the calling thread works as the worker 0, so a pool of size 1 spawns no thread
+ */
+class thread_pool_t {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::function<void (int, int)> job;
+    int job_size;
+    std::atomic<int> next;
+    int generation, running;
+    bool quit;
+    void work(int worker);
+    void drain(int worker);
+public:
+    explicit thread_pool_t(int size); // 0 means the number of cores
+    ~thread_pool_t();
+    int size() const { return threads.size() + 1; }
+    void run(int n, std::function<void (int i, int worker)> const & f); // calls f for each i < n, and waits for all of them
+};
+
+/**
+ * a bump allocator for the scratch of a turn, which frees everything at once by reset()
+ * @note the blocks are kept over resets, so a turn no larger than the previous ones does not touch the heap
+ * @note not thread safe
+ */
+class arena_t {
+    struct block_t {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+    std::vector<block_t> blocks;
+    std::size_t current, used; // the block in use, and the bytes used in it
+public:
+    explicit arena_t(std::size_t size = 1 << 16);
+    void *allocate(std::size_t n, std::size_t align);
+    void reset() { current = 0; used = 0; }
+};
+template <typename T>
+struct arena_allocator_t {
+    typedef T value_type;
+    arena_t *arena;
+    arena_allocator_t(arena_t & arena) : arena(&arena) {}
+    template <typename U>
+    arena_allocator_t(arena_allocator_t<U> const & other) : arena(other.arena) {}
+    T *allocate(std::size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *, std::size_t) {} // by reset()
+};
+template <typename T, typename U>
+bool operator == (arena_allocator_t<T> const & a, arena_allocator_t<U> const & b) { return a.arena == b.arena; }
+template <typename T, typename U>
+bool operator != (arena_allocator_t<T> const & a, arena_allocator_t<U> const & b) { return a.arena != b.arena; }
+template <typename T>
+using arena_vector_t = std::vector<T, arena_allocator_t<T> >;